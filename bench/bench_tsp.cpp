@@ -0,0 +1,264 @@
+//
+// Benchmarks of the steps of the branch & bound search and of whole solves
+// (run with --benchmark_format=json for the dashboard).
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "TSP.hpp"
+#include "tsp_pool.hpp"
+
+namespace {
+
+// Bytes requested from operator new by the whole program (the matrices of
+// the search come from a MatrixPool instead, counted separately).
+std::atomic<std::size_t> allocated_bytes{0};
+
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size == 0 ? 1 : size))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+/**
+ * A matrix of random costs in [1, 1000], the same for the same seed.
+ * @param n The number of cities.
+ * @param seed
+ * @param symmetric If set, the cost of i -> j is the cost of j -> i.
+ */
+cost_matrix_t random_matrix(std::size_t n, unsigned seed, bool symmetric)
+{
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> cost(1, 1000);
+    cost_matrix_t cm(n, std::vector<cost_t>(n, INF));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = symmetric ? i + 1 : 0; j < n; ++j)
+        {
+            if (i != j)
+            {
+                cm[i][j] = static_cast<cost_t>(cost(rng));
+                if (symmetric)
+                {
+                    cm[j][i] = cm[i][j];
+                }
+            }
+        }
+    }
+    return cm;
+}
+
+/// The root stage of a random matrix, reduced.
+StageState reduced_root(std::size_t n)
+{
+    StageState stage(CostMatrix(random_matrix(n, 1, false)));
+    stage.update_lower_bound(stage.reduce_cost_matrix());
+    return stage;
+}
+
+void reduce_rows(benchmark::State &state)
+{
+    const CostMatrix original(random_matrix(static_cast<std::size_t>(state.range(0)), 1, false));
+    CostMatrix matrix(original);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        matrix = original;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(matrix.reduce_rows());
+    }
+}
+
+void reduce_cols(benchmark::State &state)
+{
+    const CostMatrix original(random_matrix(static_cast<std::size_t>(state.range(0)), 1, false));
+    CostMatrix matrix(original);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        matrix = original;
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(matrix.reduce_cols());
+    }
+}
+
+void choose_new_vertex(benchmark::State &state)
+{
+    StageState stage = reduced_root(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(stage.choose_new_vertex());
+    }
+}
+
+void update_cost_matrix(benchmark::State &state)
+{
+    StageState root = reduced_root(static_cast<std::size_t>(state.range(0)));
+    const vertex_t v = root.choose_new_vertex().coordinates;
+    StageState stage(root);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        stage = root;
+        state.ResumeTiming();
+        stage.update_cost_matrix(v);
+    }
+}
+
+/**
+ * Solve random instances of the size given by the first argument, a new one
+ * (with the next seed) every iteration, and report the expanded nodes (the
+ * solved subsets for Held-Karp) per second, the bytes allocated per node and
+ * the time to the optimal tours.
+ */
+void solve(benchmark::State &state, bool symmetric, tsp_engine_t engine = tsp_engine_t::BranchAndBound,
+           bool skip_reversed_tours = false)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    search_stats_t stats;
+    tsp_options_t options;
+    options.engine = engine;
+    options.skip_reversed_tours = skip_reversed_tours;
+    options.stats = &stats;
+    std::size_t bytes = 0;
+    double seconds = 0;
+    unsigned seed = 1;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const cost_matrix_t cm = random_matrix(n, seed++, symmetric);
+        const std::size_t bytes_before = allocated_bytes.load();
+        state.ResumeTiming();
+
+        const auto start = std::chrono::steady_clock::now();
+        MatrixPool pool(n);
+        benchmark::DoNotOptimize(solve_tsp(cm, options, pool));
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        bytes += allocated_bytes.load() - bytes_before + pool.allocated() * pool.block_bytes();
+    }
+    const double n_nodes = static_cast<double>(stats.nodes_expanded);
+    state.counters["nodes"] = benchmark::Counter(n_nodes, benchmark::Counter::kAvgIterations);
+    state.counters["nodes_per_second"] = benchmark::Counter(n_nodes / seconds);
+    state.counters["bytes_per_node"] = benchmark::Counter(static_cast<double>(bytes) / n_nodes);
+    state.counters["time_to_optimal"] = benchmark::Counter(seconds, benchmark::Counter::kAvgIterations);
+}
+
+void solve_asymmetric(benchmark::State &state)
+{
+    solve(state, false);
+}
+
+void solve_symmetric(benchmark::State &state)
+{
+    solve(state, true);
+}
+
+/// Symmetric instances with every cycle searched in one direction only (@see: tsp_options_t::skip_reversed_tours).
+void solve_symmetric_one_direction(benchmark::State &state)
+{
+    solve(state, true, tsp_engine_t::BranchAndBound, true);
+}
+
+void solve_held_karp(benchmark::State &state)
+{
+    solve(state, false, tsp_engine_t::HeldKarp);
+}
+
+/**
+ * Re-solve random asymmetric instances of the size given by the first
+ * argument after 3% of their costs changed by up to 30% (@see: resolve_tsp()).
+ */
+void resolve_asymmetric(benchmark::State &state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    unsigned seed = 1;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        cost_matrix_t cm = random_matrix(n, seed, false);
+        const tsp_solutions_t previous = solve_tsp(cm);
+        std::mt19937 rng(seed++);
+        std::vector<cost_change_t> changes;
+        for (std::size_t k = 0; k < n * n * 3 / 100; ++k)
+        {
+            const std::size_t row = rng() % n;
+            const std::size_t col = (row + 1 + rng() % (n - 1)) % n;
+            changes.push_back({row, col, static_cast<cost_t>(cm[row][col] * static_cast<cost_t>(70 + rng() % 61) / 100)});
+        }
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(resolve_tsp(cm, changes, previous));
+    }
+}
+
+/**
+ * Solve a batch of 1000 random instances of the size given by the first
+ * argument and report the instances solved per second and the bytes
+ * allocated per instance (the small ones go to Held-Karp, whose tables are
+ * kept by the threads of the batch).
+ */
+void solve_batch(benchmark::State &state)
+{
+    const std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<cost_matrix_t> matrices;
+    for (unsigned seed = 1; seed <= 1000; ++seed)
+    {
+        matrices.push_back(random_matrix(n, seed, false));
+    }
+    std::vector<tsp_solutions_t> results(matrices.size());
+    tsp_options_t options;
+    options.n_threads = 0;
+    std::size_t bytes = 0;
+    for (auto _ : state)
+    {
+        const std::size_t bytes_before = allocated_bytes.load();
+        solve_tsp_batch(matrices.data(), matrices.size(), results.data(), options);
+        bytes += allocated_bytes.load() - bytes_before;
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * matrices.size()));
+    state.counters["bytes_per_instance"] =
+        benchmark::Counter(static_cast<double>(bytes) / static_cast<double>(state.iterations() * matrices.size()));
+}
+
+} // namespace
+
+BENCHMARK(reduce_rows)->RangeMultiplier(2)->Range(8, 512);
+BENCHMARK(reduce_cols)->RangeMultiplier(2)->Range(8, 512);
+BENCHMARK(choose_new_vertex)->RangeMultiplier(2)->Range(8, 512);
+BENCHMARK(update_cost_matrix)->RangeMultiplier(2)->Range(8, 512);
+BENCHMARK(solve_asymmetric)->DenseRange(10, 40, 10)->Unit(benchmark::kMillisecond);
+BENCHMARK(solve_symmetric)->DenseRange(8, 24, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK(solve_symmetric_one_direction)->DenseRange(8, 24, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK(solve_held_karp)->DenseRange(8, 20, 4)->Unit(benchmark::kMillisecond);
+BENCHMARK(resolve_asymmetric)->DenseRange(20, 40, 10)->Unit(benchmark::kMillisecond);
+BENCHMARK(solve_batch)->DenseRange(8, 20, 4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
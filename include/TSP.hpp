@@ -5,14 +5,21 @@
 #ifndef IMPLEMENTATION_TSP_HPP
 #define IMPLEMENTATION_TSP_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <vector>
 #include <numeric>
 #include <ostream>
+#include <cstddef>
 
 #include "tsp_setup.hpp"
 
 using cost_matrix_t = std::vector<std::vector<cost_t>>;
 
+class MatrixPool;
+class IBoundingEngine;
+
 struct vertex_t {
     std::size_t row;
     std::size_t col;
@@ -26,8 +33,23 @@ struct tsp_solution_t {
     path_t path;
 };
 
+/// A new cost of a cell of the cost matrix (@see: resolve_tsp()).
+struct cost_change_t {
+    std::size_t row;
+    std::size_t col;
+    cost_t cost;
+};
+
 using tsp_solutions_t = std::vector<tsp_solution_t>;
 
+/// The two smallest values of every row and column (duplicates count twice).
+struct line_minima_t {
+    std::vector<cost_t> row_first;
+    std::vector<cost_t> row_second;
+    std::vector<cost_t> col_first;
+    std::vector<cost_t> col_second;
+};
+
 struct NewVertex {
     NewVertex(vertex_t v = {}, cost_t cost = 0) : coordinates(v), cost(cost) {}
 
@@ -35,16 +57,53 @@ struct NewVertex {
     cost_t cost;
 };
 
+/**
+ * Square cost matrix stored as a single row-major buffer.
+ *
+ * Every row is padded to <tt>stride()</tt> elements so that each row starts on
+ * a cache line boundary; the padding cells hold INF, so scanning a whole
+ * padded row never changes a minimum.
+ *
+ * The matrix caches the minimum of every row and column. Cells changed with
+ * <tt>set()</tt> or removed with <tt>erase()</tt> only mark the rows and
+ * columns whose minimum may have changed, so that the following reduction
+ * rescans just those. Writing through the non-const <tt>operator[]</tt>
+ * invalidates the whole cache.
+ *
+ * The cells and the cached minima share a single buffer, taken from a
+ * <tt>MatrixPool</tt> if one is given and from the heap otherwise. Erasing a
+ * row and a column compacts the matrix within its buffer.
+ */
 class CostMatrix {
 public:
-    CostMatrix(cost_matrix_t m = {}) : matrix_(m) {}
+    /// The alignment (in bytes) of the buffer and of every row.
+    static constexpr std::size_t alignment = 64;
+
+    CostMatrix(const cost_matrix_t& m = {});
+    CostMatrix(std::size_t n, cost_t value);
+    CostMatrix(const cost_matrix_t& m, MatrixPool& pool);
+
+    CostMatrix(const CostMatrix& other);
+    CostMatrix(CostMatrix&& other) noexcept;
+    CostMatrix& operator=(const CostMatrix& other);
+    CostMatrix& operator=(CostMatrix&& other) noexcept;
+    ~CostMatrix();
+
+    std::size_t size() const { return size_; }
+    std::size_t stride() const { return stride_; }
+    std::size_t memory_usage() const;
+    MatrixPool* get_pool() const { return pool_; }
 
-    std::size_t size() const { return matrix_.size(); }
+    static std::size_t block_bytes(std::size_t capacity);
 
-    const std::vector<cost_t>& operator[](std::size_t pos) const { return matrix_[pos]; }
-    std::vector<cost_t>& operator[](std::size_t pos) { return matrix_[pos]; }
+    const cost_t* operator[](std::size_t pos) const { return row(pos); }
+    cost_t* operator[](std::size_t pos) { minima_stale_ = true; return row(pos); }
 
-    const cost_matrix_t& get_matrix() const { return matrix_; };
+    cost_matrix_t get_matrix() const;
+
+    void set(std::size_t r, std::size_t c, cost_t value);
+    void erase(std::size_t r, std::size_t c);
+    void subtract(const std::vector<cost_t>& row_values, const std::vector<cost_t>& col_values);
 
     cost_t reduce_rows();
     cost_t reduce_cols();
@@ -53,50 +112,331 @@ public:
     std::vector<cost_t> get_min_values_in_cols() const;
 
     cost_t get_vertex_cost(std::size_t row, std::size_t col) const;
+    void get_two_smallest_values(line_minima_t& minima) const;
 
 private:
-    cost_matrix_t matrix_;
+    const cost_t* row(std::size_t pos) const { return data_ + pos * stride_; }
+    cost_t* row(std::size_t pos) { return data_ + pos * stride_; }
+
+    void allocate(std::size_t n);
+    void attach(std::size_t capacity, MatrixPool* pool);
+    void release();
+    void refresh_minima();
+    cost_t col_min(std::size_t c) const;
+    cost_t reduce_cols_rowwise();
+
+    std::size_t size_ = 0;
+    std::size_t stride_ = 0;
+    // The size of the largest matrix the buffer can hold.
+    std::size_t capacity_ = 0;
+    MatrixPool* pool_ = nullptr;
+    cost_t* data_ = nullptr;
+
+    // Cached minima (stored in the buffer after the cells); a line marked
+    // dirty has to be rescanned before use.
+    cost_t* row_min_ = nullptr;
+    cost_t* col_min_ = nullptr;
+    unsigned char* row_dirty_ = nullptr;
+    unsigned char* col_dirty_ = nullptr;
+    bool minima_stale_ = true;
 };
 
 std::ostream& operator<<(std::ostream& os, const CostMatrix& cm);
 
+/// What bounding engines keep in a stage for its branches to start from (@see: IBoundingEngine).
+struct bound_state_t {
+    /// Lagrangian penalties of the cities (@see: OneTreeBound).
+    std::vector<double> penalties;
+    /// The column assigned to every row, both in the original matrix (@see: AssignmentBound).
+    std::vector<std::size_t> assignment;
+};
+
 /**
  * The <tt>StageState</tt> class stores information about the partial solution
  * at the given stage.
  */
 class StageState : public IStageState {
 public:
-
+    /// How the cost matrix of a stage is kept as vertices are added to the path.
+    enum class Layout {
+        /// Keep the N x N matrix and overwrite chosen rows and columns with INF.
+        Full,
+        /// Drop chosen rows and columns, so a level-k stage holds an (N-k) x (N-k) matrix.
+        Shrinking
+    };
 
     StageState(const CostMatrix& m, std::vector<vertex_t> p = {},
-            cost_t lb = 0) : matrix_(m), unsorted_path_(p), lower_bound_(lb) {};
+            cost_t lb = 0, Layout layout = Layout::Full);
 
     path_t get_path();
     std::size_t get_level() const { return unsorted_path_.size(); }
 
-    void update_lower_bound(cost_t reduced_values) { lower_bound_ += reduced_values; }
-    cost_t get_lower_bound() const { return lower_bound_; }
-    void reset_lower_bound() { lower_bound_ = 0; }
+    void update_lower_bound(cost_t reduced_values) { lower_bound_ = add_costs(lower_bound_, reduced_values); }
+    /// The best lower bound known: the reduction sum or a bound raised by a bounding engine.
+    cost_t get_lower_bound() const { return std::max(lower_bound_, bound_); }
+    void reset_lower_bound() { lower_bound_ = 0; bound_ = 0; }
+    /// The sum of values reduced so far (@see: reduce_cost_matrix()).
+    cost_t get_reduction_sum() const { return lower_bound_; }
+    void raise_lower_bound(cost_t bound) { bound_ = std::max(bound_, bound); }
+    bound_state_t& get_bound_state() { return bound_state_; }
 
     const CostMatrix& get_matrix() const { return matrix_; };
     const unsorted_path_t& get_unsorted_path() const { return unsorted_path_; }
     void append_to_path(const vertex_t& v) { unsorted_path_.push_back(v); }
 
+    Layout get_layout() const { return layout_; }
+    /// Indexes (in the original matrix) of rows not yet left by the path.
+    const std::vector<std::size_t>& get_rows() const { return rows_; }
+    /// Indexes (in the original matrix) of columns not yet entered by the path.
+    const std::vector<std::size_t>& get_cols() const { return cols_; }
+    std::size_t memory_usage() const;
+
     cost_t reduce_cost_matrix();
     NewVertex choose_new_vertex();
     void update_cost_matrix(vertex_t new_vertex);
+    void forbid(vertex_t v);
+    /// Let the branches skip the tours going the reverse way round (@see: create_right_branch_matrix()).
+    void skip_reversed_tours() { skip_reversed_ = true; }
+    bool skips_reversed_tours() const { return skip_reversed_; }
+    void apply_potentials(const std::vector<cost_t>& row_values, const std::vector<cost_t>& col_values);
 
 private:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /// The ends of the path fragments (every city not on the path is a fragment of its own).
+    struct fragment_ends_t {
+        /// The first city of the fragment ending at this city (valid if no vertex leaves it).
+        std::size_t first;
+        /// The last city of the fragment starting at this city (valid if no vertex enters it).
+        std::size_t last;
+    };
+
+    vertex_t link(vertex_t v);
+    std::size_t local_row(std::size_t row) const;
+    std::size_t local_col(std::size_t col) const;
+    vertex_t to_global(std::size_t row, std::size_t col) const;
+    void remove_row_col(std::size_t row, std::size_t col);
+
     CostMatrix matrix_;
     unsorted_path_t unsorted_path_;
     cost_t lower_bound_;
+    cost_t bound_ = 0;
+    bound_state_t bound_state_;
+    Layout layout_;
+    std::vector<std::size_t> rows_;
+    std::vector<std::size_t> cols_;
+    std::vector<fragment_ends_t> fragments_;
+    bool skip_reversed_ = false;
 };
 
 //NewVertex choose_new_vertex(const CostMatrix& cm);
 cost_t get_optimal_cost(const path_t& optimal_path, const cost_matrix_t& m);
-StageState create_right_branch_matrix(cost_matrix_t m, vertex_t v, cost_t lb);
+StageState create_right_branch_matrix(const StageState& parent, vertex_t v);
 tsp_solutions_t filter_solutions(tsp_solutions_t solutions);
+bool is_symmetric(const cost_matrix_t& cm);
+
+/// The order in which the solver visits the open stages of the tree.
+enum class search_strategy_t {
+    /// Always continue with the most recently opened stage.
+    DepthFirst,
+    /// Always continue with the open stage with the lowest lower bound.
+    BestFirst,
+    /// Dive depth first down to a leaf, then jump to the open stage with the lowest lower bound.
+    Hybrid
+};
+
+/// The exact algorithm of solve_tsp().
+enum class tsp_engine_t {
+    /**
+     * Held-Karp for instances small enough (@see: tsp_options_t::held_karp_max_cities
+     * and tsp_options_t::held_karp_max_bytes), branch & bound otherwise.
+     */
+    Auto,
+    /// Little's branch & bound, whose time depends on how well the matrix prunes.
+    BranchAndBound,
+    /// The Held-Karp dynamic program, taking O(2^N * N^2) time and O(2^N * N) memory whatever the matrix.
+    HeldKarp
+};
+
+/// How well the heuristic tour seeding the search did (@see: tsp_options_t::warm_start).
+struct warm_start_report_t {
+    /// The cost of the heuristic tour (INF if it has forbidden transitions).
+    cost_t heuristic_cost = INF;
+    /// The cost of the optimal tours (INF if there is none).
+    cost_t optimal_cost = INF;
+    /// The time taken by the heuristics.
+    double seconds = 0;
+
+    double gap() const;
+};
+
+/// A new best tour found by the search (@see: search_stats_t).
+struct incumbent_t {
+    cost_t cost;
+    /// The time since the search started (0 for the tour of the warm start).
+    double seconds;
+};
+
+/**
+ * What the search did and where it spent its time (@see: tsp_options_t::stats).
+ * The search adds to the counters, so the stats of several solves can be
+ * summed. Nothing is collected if the library is built with TSP_NO_STATS.
+ */
+struct search_stats_t {
+    /// Stages split into their left and right branches (for the Held-Karp engine: the subsets of cities solved).
+    std::size_t nodes_expanded = 0;
+    /// Stages (or right branches) dropped since their lower bound exceeds the cost of the best tour.
+    std::size_t nodes_pruned = 0;
+    /// The most stages waiting at the same time (on the stack, in the queues or in the open list).
+    std::size_t max_depth = 0;
+    /// Every improvement of the best tour, in the order found.
+    std::vector<incumbent_t> incumbents;
+
+    /// The time spent reducing the matrices.
+    double reduction_seconds = 0;
+    /// The time spent in the bounding engine.
+    double bound_seconds = 0;
+    /// The time spent choosing the vertices to branch on.
+    double selection_seconds = 0;
+    /// The time spent creating the branches (updating their matrices).
+    double update_seconds = 0;
+    /// The time spent closing the leaves into tours.
+    double path_seconds = 0;
+
+    void merge(const search_stats_t& other);
+};
+
+/// Lets another thread stop a search early (@see: tsp_options_t::cancel).
+class CancellationToken {
+public:
+    void cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return cancelled_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<bool> cancelled_{false};
+};
+
+/// How far the search got (@see: tsp_options_t::outcome).
+struct search_outcome_t {
+    /**
+     * Whether the whole tree was searched, so that the tours returned are all
+     * the optimal ones (up to tsp_options_t::max_tours of them).
+     */
+    bool complete = true;
+    /// The cost of the tours returned (INF if there is none).
+    cost_t best_cost = INF;
+    /// A lower bound on the cost of every tour (the optimal cost once the search is complete).
+    cost_t lower_bound = INF;
+
+    double gap() const;
+};
+
+/// Settings of the solver (@see: solve_tsp()).
+struct tsp_options_t {
+    /// The exact algorithm; the settings of the tree search below do not apply to the Held-Karp engine.
+    tsp_engine_t engine = tsp_engine_t::Auto;
+    /// The most cities for which the automatic choice picks the Held-Karp engine.
+    std::size_t held_karp_max_cities = 12;
+    /// The most memory (in bytes) the automatic choice lets the Held-Karp engine take (@see: get_held_karp_bytes()).
+    std::size_t held_karp_max_bytes = std::size_t(64) << 20;
+    /**
+     * If set, the Held-Karp engine keeps its table here instead of allocating
+     * it for every solve: the vector only grows, so solves of no more cities
+     * than before reuse it (e.g. in a batch). Used by one solve at a time.
+     */
+    std::vector<cost_t>* held_karp_table = nullptr;
+    /// The number of threads searching the tree or solving the subsets of a size (0 = one per hardware thread).
+    std::size_t n_threads = 1;
+    /// The node selection of the single-threaded solver; the parallel one always dives depth first.
+    search_strategy_t strategy = search_strategy_t::DepthFirst;
+    /**
+     * The most memory (in bytes) the open stages of the best-first and hybrid
+     * strategies may take (0 = no limit). Once it is reached, stages are
+     * searched depth first to the end instead of being added to the open list.
+     */
+    std::size_t max_open_bytes = 0;
+    /**
+     * Search depth first on a single matrix, undoing the changes of a stage
+     * when backtracking from it instead of copying the matrix for every stage
+     * (@see: solve_tsp_trail()). Used by the single-threaded depth-first search only.
+     */
+    bool undo_trail = false;
+    /**
+     * Start the search with the cost of a heuristic tour as the best cost
+     * (@see: get_heuristic_solution()), so that it prunes before reaching its
+     * first leaf. The Held-Karp engine, which does not prune, only takes the
+     * tour as the one to return if a limit stops it, so the heuristics are
+     * skipped unless a limit is set.
+     */
+    bool warm_start = true;
+    /// If set, filled in with the outcome of the warm start.
+    warm_start_report_t* warm_start_report = nullptr;
+    /**
+     * A lower bound computed for every stage on top of the reduction sum
+     * (nullptr = the reduction sum only; @see: IBoundingEngine). Not used by
+     * the undo trail search.
+     */
+    const IBoundingEngine* bound = nullptr;
+    /// If set, the statistics of the search are added to it (nullptr = not collected).
+    search_stats_t* stats = nullptr;
+
+    /**
+     * The most tours returned (0 = all the optimal ones, 1 = the first optimal
+     * tour only). Once that many tours as cheap as the best one are kept, the
+     * search only looks for cheaper ones, so it prunes the ties too.
+     */
+    std::size_t max_tours = 0;
+    /**
+     * Return every cycle of a symmetric matrix in a single direction (every
+     * tour starts in the first city, so a cycle never comes in several
+     * rotations). The tree search then never visits the reverse of a tour,
+     * which takes about half of its stages; the direction it keeps depends on
+     * the vertices it branches on. The Held-Karp engine keeps the tour whose
+     * second city is lower than its last one.
+     */
+    bool skip_reversed_tours = false;
+    /**
+     * If set, called with every tour the search keeps, as soon as it is found
+     * (by one thread at a time). The tours passed never get more expensive;
+     * a tour is optimal unless a cheaper one follows it.
+     */
+    std::function<void(const tsp_solution_t&)> on_tour;
+
+    /**
+     * The time (in seconds, including the warm start) after which the search
+     * stops (0 = no limit). A search stopped early by any of the limits
+     * returns the cheapest tours found so far (or the tour of the warm start),
+     * not necessarily all of them; @see: outcome.
+     */
+    double time_limit = 0;
+    /// The number of expanded stages after which the search stops (0 = no limit).
+    std::size_t node_limit = 0;
+    /// If set, the search stops once it is cancelled.
+    const CancellationToken* cancel = nullptr;
+    /**
+     * If set, filled in with how far the search got: the cost of the tours
+     * returned and a lower bound from the stages left open. The limits are
+     * checked whenever the search takes an open stage, so it may go over the
+     * node limit by the depth of a single dive.
+     */
+    search_outcome_t* outcome = nullptr;
+};
 
 tsp_solutions_t solve_tsp(const cost_matrix_t& cm);
+tsp_solutions_t solve_tsp(const cost_matrix_t& cm, const tsp_options_t& options);
+tsp_solutions_t solve_tsp(const cost_matrix_t& cm, const tsp_options_t& options, MatrixPool& pool);
+tsp_solutions_t resolve_tsp(cost_matrix_t& cm, const std::vector<cost_change_t>& changes,
+                            const tsp_solutions_t& previous, const tsp_options_t& options = {});
+tsp_solutions_t solve_tsp_parallel(const cost_matrix_t& cm, const tsp_options_t& options, MatrixPool& pool,
+                                   cost_t upper_bound = INF);
+tsp_solutions_t solve_tsp_best_first(const cost_matrix_t& cm, const tsp_options_t& options, MatrixPool& pool,
+                                     cost_t upper_bound = INF);
+tsp_solutions_t solve_tsp_trail(const cost_matrix_t& cm, const tsp_options_t& options, cost_t upper_bound = INF);
+tsp_solutions_t solve_tsp_held_karp(const cost_matrix_t& cm, const tsp_options_t& options);
+std::size_t get_held_karp_bytes(std::size_t n);
+void solve_tsp_batch(const cost_matrix_t* matrices, std::size_t n_matrices, tsp_solutions_t* results,
+                     const tsp_options_t& options = {});
+std::vector<tsp_solutions_t> solve_tsp_batch(const std::vector<cost_matrix_t>& matrices,
+                                             const tsp_options_t& options = {});
 
 #endif //IMPLEMENTATION_TSP_HPP
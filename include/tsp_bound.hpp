@@ -0,0 +1,76 @@
+//
+// Lower bounds on the cost of the tours extending a stage, used by the
+// search on top of the reduction sum.
+//
+
+#ifndef IMPLEMENTATION_TSP_BOUND_HPP
+#define IMPLEMENTATION_TSP_BOUND_HPP
+
+#include <cstddef>
+
+#include "TSP.hpp"
+
+/**
+ * A bounding engine gives a lower bound on the cost of every tour extending a
+ * stage (@see: tsp_options_t::bound). The search prunes a stage whose bound
+ * exceeds the cost of the best tour. The engine may keep state in the stage
+ * (e.g. its penalties), which the branches of the stage inherit.
+ * Implementations must be safe to call from several threads at once.
+ */
+class IBoundingEngine {
+public:
+    virtual ~IBoundingEngine() = default;
+
+    /**
+     * @param stage A stage with a reduced matrix.
+     * @param best_lb The cost of the best tour found so far.
+     * @return A lower bound on the cost of the tours extending the stage (INF if there is none).
+     */
+    virtual cost_t get_lower_bound(StageState& stage, cost_t best_lb) const = 0;
+};
+
+/**
+ * The Held-Karp bound: the cost of the cheapest 1-tree under Lagrangian
+ * penalties of the cities, improved by subgradient optimization.
+ *
+ * The tours extending a stage are the tours through the path fragments of the
+ * stage (each contracted into a single city) in its reduced matrix; the cost
+ * of an edge between two cities is the cheaper of its two directions. The
+ * penalties are kept in the stage, so that its branches start from them.
+ */
+class OneTreeBound : public IBoundingEngine {
+public:
+    /**
+     * @param root_iterations Subgradient steps for a stage without penalties (the root).
+     * @param iterations Subgradient steps for a stage starting from the penalties of its parent.
+     */
+    explicit OneTreeBound(std::size_t root_iterations = 100, std::size_t iterations = 10)
+        : root_iterations_(root_iterations), iterations_(iterations) {}
+
+    cost_t get_lower_bound(StageState& stage, cost_t best_lb) const override;
+
+private:
+    std::size_t root_iterations_;
+    std::size_t iterations_;
+};
+
+/**
+ * The assignment bound: the cost of the cheapest assignment of the rows of the
+ * reduced matrix to its columns, found with shortest augmenting paths
+ * (Hungarian method with dual potentials).
+ *
+ * The reduction by rows and columns is a cheap approximation of the
+ * potentials; the exact ones are folded into the stage as a further
+ * reduction, so that the assigned cells become zeros. The assignment is kept
+ * in the stage: a branch only loses the cells forbidden or removed since its
+ * parent, and re-assigns their rows with one augmenting path each, in O(N^2).
+ * Suits asymmetric matrices, where the 1-tree bound is weak. The stronger
+ * reduction changes the vertices chosen, so the optimal tours may come in a
+ * different order than without a bounding engine.
+ */
+class AssignmentBound : public IBoundingEngine {
+public:
+    cost_t get_lower_bound(StageState& stage, cost_t best_lb) const override;
+};
+
+#endif //IMPLEMENTATION_TSP_BOUND_HPP
@@ -0,0 +1,76 @@
+//
+// Costs between cities given by their coordinates, computed on demand
+// instead of being stored in an N x N matrix.
+//
+
+#ifndef IMPLEMENTATION_TSP_DISTANCE_HPP
+#define IMPLEMENTATION_TSP_DISTANCE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "TSP.hpp"
+
+/// A city given by its coordinates.
+struct point_t {
+    double x;
+    double y;
+};
+
+/// How a Euclidean distance is turned into an integer cost.
+enum class rounding_t {
+    /// To the nearest integer (TSPLIB EUC_2D).
+    Nearest,
+    /// Up to the next integer (TSPLIB CEIL_2D).
+    Up
+};
+
+cost_t get_distance(const point_t& a, const point_t& b, rounding_t rounding);
+
+/**
+ * The cost matrix of cities given by their coordinates (the rounded
+ * Euclidean distances, INF on the diagonal), without storing it: O(N)
+ * memory instead of O(N^2).
+ *
+ * Single costs are computed on every call. Whole rows, for code scanning
+ * them, are kept in a small cache which evicts the least recently used row.
+ * Costs may be read from several threads at once, rows may not.
+ */
+class PointDistances {
+public:
+    /**
+     * @param points
+     * @param rounding
+     * @param cached_rows How many rows the cache keeps (at least one).
+     */
+    explicit PointDistances(std::vector<point_t> points, rounding_t rounding = rounding_t::Nearest,
+                            std::size_t cached_rows = 16);
+
+    std::size_t size() const { return points_.size(); }
+    const std::vector<point_t>& get_points() const { return points_; }
+    rounding_t get_rounding() const { return rounding_; }
+
+    cost_t operator()(std::size_t from, std::size_t to) const
+    {
+        return (from == to) ? INF : get_distance(points_[from], points_[to], rounding_);
+    }
+
+    const cost_t* row(std::size_t from) const;
+    cost_matrix_t get_matrix() const;
+    std::size_t memory_usage() const;
+
+private:
+    struct cached_row_t {
+        std::size_t city;
+        std::size_t last_used;
+        std::vector<cost_t> costs;
+    };
+
+    std::vector<point_t> points_;
+    rounding_t rounding_;
+    std::size_t cached_rows_;
+    mutable std::vector<cached_row_t> cache_;
+    mutable std::size_t clock_ = 0;
+};
+
+#endif //IMPLEMENTATION_TSP_DISTANCE_HPP
@@ -0,0 +1,22 @@
+//
+// Construction and local search heuristics giving good (not necessarily
+// optimal) tours quickly, e.g. as the initial upper bound of the search.
+//
+
+#ifndef IMPLEMENTATION_TSP_HEURISTICS_HPP
+#define IMPLEMENTATION_TSP_HEURISTICS_HPP
+
+#include <cstddef>
+
+#include "TSP.hpp"
+
+path_t get_nearest_neighbour_path(const cost_matrix_t& cm, std::size_t start = 0);
+path_t get_greedy_edge_path(const cost_matrix_t& cm);
+
+bool improve_two_opt(const cost_matrix_t& cm, path_t& path);
+bool improve_or_opt(const cost_matrix_t& cm, path_t& path, std::size_t max_length = 3);
+
+tsp_solution_t get_improved_solution(const cost_matrix_t& cm, path_t path);
+tsp_solution_t get_heuristic_solution(const cost_matrix_t& cm);
+
+#endif //IMPLEMENTATION_TSP_HEURISTICS_HPP
@@ -0,0 +1,71 @@
+//
+// Vectorized kernels for scanning and reducing rows of a cost matrix (and for
+// the min-plus steps of the Held-Karp engine).
+//
+
+#ifndef IMPLEMENTATION_TSP_KERNELS_HPP
+#define IMPLEMENTATION_TSP_KERNELS_HPP
+
+#include <cstddef>
+
+#include "tsp_setup.hpp"
+
+/// Instruction sets the kernels can be dispatched to.
+enum class simd_level_t {
+    Scalar,
+    SSE41,
+    AVX2
+};
+
+/**
+ * Row kernels used by <tt>CostMatrix</tt>. Every kernel processes <tt>n</tt>
+ * consecutive cells and leaves INF cells untouched, so that forbidden
+ * transitions stay forbidden after a reduction. All implementations give
+ * bit-for-bit the same results.
+ */
+struct cost_kernels_t {
+    /// Return the minimum of the row.
+    cost_t (*row_min)(const cost_t* row, std::size_t n);
+
+    /// Return the minimum of the row and lower <tt>col_min[i]</tt> to <tt>row[i]</tt> where smaller.
+    cost_t (*row_min_accumulate)(const cost_t* row, std::size_t n, cost_t* col_min);
+
+    /// Subtract <tt>value</tt> from every finite cell and lower <tt>col_min</tt> as above.
+    void (*row_subtract)(cost_t* row, std::size_t n, cost_t value, cost_t* col_min);
+
+    /// Subtract <tt>values[i]</tt> from every finite <tt>row[i]</tt> and return the new row minimum.
+    cost_t (*row_subtract_each)(cost_t* row, std::size_t n, const cost_t* values);
+
+    /**
+     * Update the two smallest values of the row (<tt>first</tt>, <tt>second</tt>)
+     * and of every column (<tt>col_first</tt>, <tt>col_second</tt>) with the row's cells.
+     */
+    void (*two_smallest)(const cost_t* row, std::size_t n, cost_t& first, cost_t& second,
+                         cost_t* col_first, cost_t* col_second);
+
+    /**
+     * Set <tt>row[i]</tt> to the minimum, over k < <tt>n_values</tt>, of
+     * <tt>values[k] + others[k][i]</tt> (the sums taken as in add_costs();
+     * the values must be finite).
+     */
+    void (*min_plus)(cost_t* row, std::size_t n, const cost_t* values, const cost_t* const* others,
+                     std::size_t n_values);
+};
+
+/// The best instruction set supported by the CPU.
+simd_level_t get_supported_simd_level();
+
+/// The instruction set the kernels are currently dispatched to.
+simd_level_t get_simd_level();
+
+/**
+ * Dispatch the kernels to the given instruction set (or to the best supported
+ * one below it). Not thread-safe; meant for tests and benchmarks.
+ * @return The instruction set in effect.
+ */
+simd_level_t set_simd_level(simd_level_t level);
+
+/// The kernels for the current instruction set.
+const cost_kernels_t& get_cost_kernels();
+
+#endif //IMPLEMENTATION_TSP_KERNELS_HPP
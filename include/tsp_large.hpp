@@ -0,0 +1,30 @@
+//
+// A heuristic solver for instances far beyond the reach of the branch & bound
+// search (thousands of cities), given as a matrix or as coordinates.
+//
+
+#ifndef IMPLEMENTATION_TSP_LARGE_HPP
+#define IMPLEMENTATION_TSP_LARGE_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include "TSP.hpp"
+#include "tsp_distance.hpp"
+
+struct large_tsp_options_t {
+    /// How many of the nearest cities of every city the moves may connect it to.
+    std::size_t n_neighbours = 10;
+    /// The time (in seconds) after which the search returns the best tour found.
+    double time_limit = 1.0;
+    /// If positive, the search also stops after this many perturbations.
+    std::size_t max_kicks = 0;
+    /// Seed of the perturbations, so that runs can be repeated.
+    unsigned seed = 1;
+};
+
+tsp_solution_t solve_tsp_large(const cost_matrix_t& cm, const large_tsp_options_t& options = {});
+tsp_solution_t solve_tsp_large(const PointDistances& distances, const large_tsp_options_t& options = {});
+tsp_solution_t solve_tsp_large(const std::vector<point_t>& points, const large_tsp_options_t& options = {});
+
+#endif //IMPLEMENTATION_TSP_LARGE_HPP
@@ -0,0 +1,56 @@
+//
+// Reusable buffers for the cost matrices of the branch & bound tree.
+//
+
+#ifndef IMPLEMENTATION_TSP_POOL_HPP
+#define IMPLEMENTATION_TSP_POOL_HPP
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * A pool of fixed-size buffers, each large enough for an N x N
+ * <tt>CostMatrix</tt> together with its cached minima.
+ *
+ * A matrix created with a pool takes its buffer from it and gives the buffer
+ * back when destroyed; copies of the matrix use the same pool. Buffers are
+ * allocated only when none is free and are released when the pool is
+ * destroyed, so once the search tree stops growing it runs without heap
+ * allocations for its matrices. The pool is thread-safe and must outlive
+ * the matrices using it.
+ */
+class MatrixPool {
+public:
+    explicit MatrixPool(std::size_t n);
+    ~MatrixPool();
+
+    MatrixPool(const MatrixPool&) = delete;
+    MatrixPool& operator=(const MatrixPool&) = delete;
+
+    /// The size of the largest matrix a buffer can hold.
+    std::size_t matrix_size() const { return matrix_size_; }
+    std::size_t block_bytes() const { return block_bytes_; }
+
+    void* acquire();
+    void release(void* block);
+
+    /// The number of buffers currently borrowed.
+    std::size_t in_use() const;
+    /// The number of buffers allocated so far.
+    std::size_t allocated() const;
+    /// The largest number of buffers borrowed at the same time.
+    std::size_t high_water_mark() const;
+
+private:
+    const std::size_t matrix_size_;
+    const std::size_t block_bytes_;
+
+    mutable std::mutex mutex_;
+    std::vector<void*> free_;
+    std::size_t allocated_ = 0;
+    std::size_t in_use_ = 0;
+    std::size_t high_water_mark_ = 0;
+};
+
+#endif //IMPLEMENTATION_TSP_POOL_HPP
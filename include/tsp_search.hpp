@@ -0,0 +1,268 @@
+//
+// Steps of the branch & bound search shared by the solvers.
+//
+
+#ifndef IMPLEMENTATION_TSP_SEARCH_HPP
+#define IMPLEMENTATION_TSP_SEARCH_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "TSP.hpp"
+#include "tsp_bound.hpp"
+
+/// What happened to a stage in a single step of the search (@see: branch_step()).
+enum class step_result_t {
+    /// The stage became its left branch and can be branched further.
+    Branched,
+    /// The stage cannot lead to a tour at most as expensive as the best one.
+    Pruned,
+    /// The stage has a 2x2 matrix left and can be closed into a tour.
+    Leaf
+};
+
+/**
+ * A stage waiting to be searched, together with the branches taken from the
+ * root to reach it (false = left, true = right). Sorting tours by their
+ * branches gives the order in which the depth-first search finds them.
+ */
+struct search_node_t {
+    StageState stage;
+    std::vector<bool> branches;
+};
+
+/// A tour found by the search, with the branches leading to its leaf.
+struct found_tour_t {
+    std::vector<bool> branches;
+    tsp_solution_t solution;
+};
+
+/**
+ * Records the statistics of one thread of the search into a search_stats_t,
+ * or nothing (a null sink) if it has none. Building with TSP_NO_STATS turns
+ * every recorder into a null sink, so that the compiler drops the recording.
+ */
+class StatsRecorder {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit StatsRecorder(search_stats_t* stats = nullptr, clock::time_point start = clock::now())
+        : stats_(stats), start_(start) {}
+
+#ifdef TSP_NO_STATS
+    bool enabled() const { return false; }
+#else
+    bool enabled() const { return stats_ != nullptr; }
+#endif
+
+    void expanded(std::size_t n_nodes = 1) { if (enabled()) stats_->nodes_expanded += n_nodes; }
+    void pruned() { if (enabled()) ++stats_->nodes_pruned; }
+    /// Note the number of stages waiting.
+    void waiting(std::size_t n_stages) { if (enabled()) stats_->max_depth = std::max(stats_->max_depth, n_stages); }
+    void incumbent(cost_t cost)
+    {
+        if (enabled())
+        {
+            stats_->incumbents.push_back({cost, std::chrono::duration<double>(clock::now() - start_).count()});
+        }
+    }
+
+    /// The start of a phase (@see: add_time()).
+    clock::time_point now() const { return enabled() ? clock::now() : clock::time_point(); }
+    /// Add the time since the start of a phase to one of the times of the stats.
+    void add_time(double search_stats_t::* phase, clock::time_point since)
+    {
+        if (enabled())
+        {
+            stats_->*phase += std::chrono::duration<double>(clock::now() - since).count();
+        }
+    }
+
+private:
+    search_stats_t* stats_;
+    clock::time_point start_;
+};
+
+/**
+ * The limits of a search (@see: tsp_options_t::time_limit): the search asks
+ * whether one is reached before it takes an open stage.
+ */
+class SearchLimits {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit SearchLimits(const tsp_options_t& options)
+        : node_limit_(options.node_limit), cancel_(options.cancel), has_deadline_(options.time_limit > 0),
+          deadline_(clock::now() + std::chrono::duration_cast<clock::duration>(
+                                       std::chrono::duration<double>(options.time_limit))) {}
+
+    /**
+     * @param n_nodes The number of stages expanded so far.
+     * @return Whether the search has to stop.
+     */
+    bool reached(std::size_t n_nodes) const
+    {
+        return (node_limit_ != 0 && n_nodes >= node_limit_) || (cancel_ != nullptr && cancel_->cancelled()) ||
+               (has_deadline_ && clock::now() >= deadline_);
+    }
+
+private:
+    std::size_t node_limit_;
+    const CancellationToken* cancel_;
+    bool has_deadline_;
+    clock::time_point deadline_;
+};
+
+/**
+ * Record in the outcome (if any) that the search stopped early.
+ * @param outcome
+ * @param open_lb The lowest lower bound of the stages left open.
+ */
+inline void stop_search(search_outcome_t* outcome, cost_t open_lb)
+{
+    if (outcome != nullptr)
+    {
+        outcome->complete = false;
+        outcome->lower_bound = std::min(outcome->lower_bound, open_lb);
+    }
+}
+
+StageState get_root_stage(const cost_matrix_t& cm, const tsp_options_t& options, MatrixPool& pool);
+
+/**
+ * Perform one step of the search on the stage:
+ * - Reduce the matrix and check the lower bound against the best cost.
+ * - Choose the new vertex and hand the right branch (the same stage without
+ *   the new vertex) to <tt>on_right</tt>, unless it cannot beat the best cost.
+ * - Turn the stage into its left branch (the new vertex added to the path).
+ * @param stage
+ * @param n_levels The level at which the stage has a 2x2 matrix left.
+ * @param best_lb The cost of the best tour found so far.
+ * @param on_right Called with the right branch (an rvalue StageState).
+ * @param bound A bounding engine checked after the reduction (nullptr if none).
+ * @param stats Where the step is recorded (a null sink by default).
+ * @return What happened to the stage.
+ */
+/**
+ * @param lower_bound The lower bound of a stage.
+ * @param best_lb The bound of the tours to keep (@see: TourCollector::bound()).
+ * @return Whether the stage cannot lead to a tour to keep (a stage whose lower
+ *         bound reached INF never can, even before any tour is known).
+ */
+inline bool exceeds_bound(cost_t lower_bound, cost_t best_lb)
+{
+    return lower_bound > best_lb || is_inf(lower_bound);
+}
+
+template <typename OnRight>
+step_result_t branch_step(StageState& stage, std::size_t n_levels, cost_t best_lb, OnRight&& on_right,
+                          const IBoundingEngine* bound = nullptr, StatsRecorder stats = StatsRecorder(nullptr, {}))
+{
+    if (exceeds_bound(stage.get_lower_bound(), best_lb))
+    {
+        stats.pruned();
+        return step_result_t::Pruned;
+    }
+    if (stage.get_level() == n_levels)
+    {
+        return step_result_t::Leaf;
+    }
+
+    // 1. Reduce the matrix in rows and columns.
+    auto start = stats.now();
+    cost_t new_cost = stage.reduce_cost_matrix();
+    stats.add_time(&search_stats_t::reduction_seconds, start);
+
+    // 2. Update the lower bound and check the break condition.
+    stage.update_lower_bound(new_cost);
+    if (exceeds_bound(stage.get_lower_bound(), best_lb))
+    {
+        stats.pruned();
+        return step_result_t::Pruned;
+    }
+    if (bound != nullptr)
+    {
+        start = stats.now();
+        stage.raise_lower_bound(bound->get_lower_bound(stage, best_lb));
+        stats.add_time(&search_stats_t::bound_seconds, start);
+        if (exceeds_bound(stage.get_lower_bound(), best_lb))
+        {
+            stats.pruned();
+            return step_result_t::Pruned;
+        }
+    }
+
+    // 3. Get new vertex and the cost of not choosing it (a matrix without
+    //    zeros has no finite cost left, so no tour either).
+    start = stats.now();
+    NewVertex new_vertex = stage.choose_new_vertex();
+    stats.add_time(&search_stats_t::selection_seconds, start);
+    if (new_vertex.cost == -INF)
+    {
+        stats.pruned();
+        return step_result_t::Pruned;
+    }
+    stats.expanded();
+
+    // 4. Hand over the right branch unless it is infeasible or already worse
+    //    than the best solution (the cost of the exclusion adds to the
+    //    reduction sum only, not to a bound from the bounding engine).
+    start = stats.now();
+    if (!is_inf(new_vertex.cost) && !exceeds_bound(add_costs(stage.get_reduction_sum(), new_vertex.cost), best_lb))
+    {
+        on_right(create_right_branch_matrix(stage, new_vertex.coordinates));
+    }
+    else
+    {
+        stats.pruned();
+    }
+
+    // 5. Update the path and the cost matrix of the left branch.
+    stage.append_to_path(new_vertex.coordinates);
+    stage.update_cost_matrix(new_vertex.coordinates);
+    stats.add_time(&search_stats_t::update_seconds, start);
+    return step_result_t::Branched;
+}
+
+/**
+ * Close a leaf stage into a tour.
+ * @param stage A stage for which branch_step() returned Leaf.
+ * @param cm The original cost matrix.
+ * @param best_lb The cost of the best tour found so far.
+ * @param solution Set to the tour if it is at most as expensive as best_lb.
+ * @param stats Where the time taken is recorded (a null sink by default).
+ * @return Whether the solution was set.
+ */
+bool close_leaf(StageState& stage, const cost_matrix_t& cm, cost_t best_lb, tsp_solution_t& solution,
+                StatsRecorder stats = StatsRecorder(nullptr, {}));
+
+/**
+ * The tours a search keeps: those as cheap as the best one found so far
+ * (dropped once a cheaper one comes), at most tsp_options_t::max_tours of
+ * them, each passed to tsp_options_t::on_tour as it is kept. Several threads
+ * may add tours at the same time.
+ */
+class TourCollector {
+public:
+    TourCollector(const tsp_options_t& options, cost_t upper_bound);
+
+    /// The cost above which a stage cannot lead to a tour to keep (prune stages with a higher lower bound).
+    cost_t bound() const { return bound_.load(std::memory_order_relaxed); }
+
+    bool add(tsp_solution_t&& solution, std::vector<bool>&& branches = {});
+    tsp_solutions_t take();
+
+private:
+    std::mutex mutex_;
+    cost_t best_;
+    const std::size_t max_tours_;
+    const std::function<void(const tsp_solution_t&)>& on_tour_;
+    std::atomic<cost_t> bound_;
+    std::vector<found_tour_t> tours_;
+};
+
+#endif //IMPLEMENTATION_TSP_SEARCH_HPP
@@ -5,18 +5,50 @@
 #ifndef IMPLEMENTATION_INFINITY_HPP
 #define IMPLEMENTATION_INFINITY_HPP
 
+#include <cstdint>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
-/// The data type used to represent costs in the cost matrix.
+/**
+ * The data type used to represent costs in the cost matrix, chosen at build
+ * time (e.g. <tt>-DTSP_COST_TYPE=std::int16_t</tt> to halve the memory of the
+ * matrices, or <tt>std::int64_t</tt> for large costs; <tt>float</tt> and
+ * <tt>double</tt> work as well).
+ */
+#ifdef TSP_COST_TYPE
+using cost_t = TSP_COST_TYPE;
+#else
 using cost_t = int;
+#endif
+
+/// A type wide enough for sums of many costs (e.g. the cost of a whole tour).
+using cost_sum_t = std::conditional_t<std::is_floating_point<cost_t>::value, double, long long>;
 
-/// A cost representing a forbidden transition.
+/**
+ * A cost representing a forbidden transition. Sums of costs saturate at INF
+ * (@see: add_costs()), so a tour costing INF or more cannot be told apart
+ * from one with a forbidden transition and is reported as infeasible.
+ */
 const cost_t INF = std::numeric_limits<cost_t>::max();
 
+/**
+ * The cost of a forbidden transition for code which sums costs as finite
+ * numbers (the heuristics): INF when cost_sum_t is a wider integer, otherwise
+ * a value which leaves room for sums of many of them (and, for floating-point
+ * costs, keeps such sums exact, since finite costs added to FLT_MAX are lost).
+ */
+const cost_sum_t FORBIDDEN_COST = std::is_floating_point<cost_t>::value ? static_cast<cost_sum_t>(1LL << 40)
+                                  : sizeof(cost_sum_t) > sizeof(cost_t)
+                                  ? static_cast<cost_sum_t>(INF)
+                                  : std::numeric_limits<cost_sum_t>::max() / (1 << 20);
+
 /// Test if a cost represents a forbidden transition.
 bool is_inf(cost_t val);
 
+/// Add two costs; the sum is INF if any of them is INF or if it would reach INF.
+cost_t add_costs(cost_t a, cost_t b);
+
 /// Represents a path (i.e., a sequence of vertices' indexes).
 using path_t = std::vector<std::size_t>;
 
@@ -0,0 +1,43 @@
+//
+// Loading instances in the TSPLIB format.
+//
+
+#ifndef IMPLEMENTATION_TSP_TSPLIB_HPP
+#define IMPLEMENTATION_TSP_TSPLIB_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "TSP.hpp"
+#include "tsp_distance.hpp"
+
+/// How the costs of a TSPLIB instance are given (EDGE_WEIGHT_TYPE).
+enum class tsplib_weight_type_t {
+    /// In EDGE_WEIGHT_SECTION, as a full matrix or one of its triangles.
+    Explicit,
+    /// Euclidean distances between coordinates, rounded to the nearest integer.
+    Euc2D,
+    /// Euclidean distances between coordinates, rounded up.
+    Ceil2D,
+    /// Distances on the Earth between coordinates given as DDD.MM latitude and longitude.
+    Geo
+};
+
+struct tsplib_instance_t {
+    std::string name;
+    tsplib_weight_type_t weight_type = tsplib_weight_type_t::Explicit;
+    /// The costs of an EXPLICIT instance (empty for the others).
+    cost_matrix_t matrix;
+    /// The coordinates of the cities (empty for an EXPLICIT instance).
+    std::vector<point_t> points;
+
+    std::size_t size() const { return weight_type == tsplib_weight_type_t::Explicit ? matrix.size() : points.size(); }
+};
+
+tsplib_instance_t load_tsplib(const std::string& path);
+
+cost_t get_tsplib_distance(const tsplib_instance_t& instance, std::size_t from, std::size_t to);
+cost_matrix_t get_cost_matrix(const tsplib_instance_t& instance);
+
+#endif //IMPLEMENTATION_TSP_TSPLIB_HPP
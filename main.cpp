@@ -1,55 +1,244 @@
+#include <cstdlib>
+#include <exception>
 #include <iostream>
+#include <string>
+
 #include <TSP.hpp>
+#include <tsp_bound.hpp>
+#include <tsp_large.hpp>
+#include <tsp_tsplib.hpp>
+
+namespace {
+
+void print_usage(const char *program)
+{
+    std::cerr << "Usage: " << program << " [options] FILE\n"
+              << "Solve the TSPLIB instance in FILE and print the cost and the path of the tours found.\n"
+              << "\n"
+              << "  --solver=exact|heuristic    branch & bound (all optimal tours) or the large-instance\n"
+              << "                              heuristic (one good tour); default: exact\n"
+              << "  --engine=auto|branch-and-bound|held-karp\n"
+              << "                              exact algorithm; auto takes Held-Karp up to 12 cities; default: auto\n"
+              << "  --threads=N                 threads of the exact search (0 = all cores); default: 1\n"
+              << "  --strategy=depth-first|best-first|hybrid\n"
+              << "                              node selection of the exact search; default: depth-first\n"
+              << "  --bound=none|one-tree|assignment\n"
+              << "                              lower bound on top of the reduction; default: none\n"
+              << "  --max-open-bytes=N          memory cap of the best-first open list (0 = none)\n"
+              << "  --undo-trail                search a single matrix with an undo trail\n"
+              << "  --max-tours=N               print at most N optimal tours (0 = all); default: 0\n"
+              << "  --one-direction             print every cycle of a symmetric instance in one direction only\n"
+              << "  --no-warm-start             do not seed the exact search with a heuristic tour\n"
+              << "  --stats                     print the statistics of the exact search to stderr\n"
+              << "  --time-limit=SECONDS        time limit of the heuristic (default: 1) or of the exact\n"
+              << "                              search (default: none), which then prints the best tours found\n"
+              << "  --node-limit=N              stop the exact search after N expanded stages\n"
+              << "  --neighbours=K              candidate neighbours of the heuristic; default: 10\n"
+              << "  --seed=N                    seed of the heuristic; default: 1\n";
+}
+
+void print_solution(const tsp_solution_t &solution)
+{
+    std::cout << solution.lower_bound << " :";
+    for (std::size_t city : solution.path)
+    {
+        std::cout << " " << city;
+    }
+    std::cout << "\n";
+}
 
-int main()
+void print_stats(const search_stats_t &stats)
 {
-    cost_matrix_t cm = {{INF, 10, 8, 19, 12},
-                        {10, INF, 20, 6, 3},
-                        {8, 20, INF, 4, 2},
-                        {19, 6, 4, INF, 7},
-                        {12, 3, 2, 7, INF}};
-
-    /* Rozwiązania:
-     * 32 : 2 3 4 1 0
-     * 32 : 1 4 3 2 0
-     */
-
-    //    cost_matrix_t cm {
-    //            {INF, 12,   3,  45,   6},
-    //            {78, INF,  90,  21,   3},
-    //            { 5,  56, INF,  23,  98},
-    //            {12,   6,   8, INF,  34},
-    //            { 3,  98,   3,   2, INF}
-    //    };
-
-    /* Rozwiązanie:
-     * 30 : 4 3 2 0 1
-     */
-
-    //    cost_matrix_t cm {
-    //            {INF,  3,  4,  2,  7},
-    //            {3,  INF,  4,  6,  3},
-    //            {4,  4,  INF,  5,  8},
-    //            {2,  6,  5,  INF,  6},
-    //            {7,  3,  8,  6,  INF},
-    //    };
-
-    /* Rozwiązania:
-     * 19 : 4 3 0 2 1
-     * 19 : 1 2 0 3 4
-     */
-
-    tsp_solutions_t solutions = solve_tsp(cm);
-    std::cout << solutions.size();
-    for (auto elem : solutions)
+    std::cerr << "nodes expanded: " << stats.nodes_expanded << "\n"
+              << "nodes pruned: " << stats.nodes_pruned << "\n"
+              << "max depth: " << stats.max_depth << "\n"
+              << "time (s): reduction " << stats.reduction_seconds << ", bound " << stats.bound_seconds
+              << ", selection " << stats.selection_seconds << ", update " << stats.update_seconds << ", path "
+              << stats.path_seconds << "\n"
+              << "incumbents:";
+    for (const incumbent_t &incumbent : stats.incumbents)
     {
-        std::cout << elem.lower_bound << " : ";
-        for (auto pelem : elem.path)
+        std::cerr << " " << incumbent.cost << " (" << incumbent.seconds << " s)";
+    }
+    std::cerr << "\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    tsp_options_t options;
+    large_tsp_options_t large_options;
+    bool heuristic = false;
+    bool print_search_stats = false;
+    std::string bound_name = "none";
+    std::string path;
+
+    try
+    {
+        for (int k = 1; k < argc; ++k)
         {
-            std::cout << pelem << " ";
+            const std::string arg = argv[k];
+            const auto equals = arg.find('=');
+            const std::string key = arg.substr(0, equals);
+            const std::string value = (equals == std::string::npos) ? std::string() : arg.substr(equals + 1);
+            if (key == "--solver" && (value == "exact" || value == "heuristic"))
+            {
+                heuristic = (value == "heuristic");
+            }
+            else if (key == "--engine" && value == "auto")
+            {
+                options.engine = tsp_engine_t::Auto;
+            }
+            else if (key == "--engine" && value == "branch-and-bound")
+            {
+                options.engine = tsp_engine_t::BranchAndBound;
+            }
+            else if (key == "--engine" && value == "held-karp")
+            {
+                options.engine = tsp_engine_t::HeldKarp;
+            }
+            else if (key == "--threads")
+            {
+                options.n_threads = std::stoul(value);
+            }
+            else if (key == "--strategy" && value == "depth-first")
+            {
+                options.strategy = search_strategy_t::DepthFirst;
+            }
+            else if (key == "--strategy" && value == "best-first")
+            {
+                options.strategy = search_strategy_t::BestFirst;
+            }
+            else if (key == "--strategy" && value == "hybrid")
+            {
+                options.strategy = search_strategy_t::Hybrid;
+            }
+            else if (key == "--bound" && (value == "none" || value == "one-tree" || value == "assignment"))
+            {
+                bound_name = value;
+            }
+            else if (key == "--max-open-bytes")
+            {
+                options.max_open_bytes = std::stoul(value);
+            }
+            else if (arg == "--undo-trail")
+            {
+                options.undo_trail = true;
+            }
+            else if (key == "--max-tours")
+            {
+                options.max_tours = std::stoul(value);
+            }
+            else if (arg == "--one-direction")
+            {
+                options.skip_reversed_tours = true;
+            }
+            else if (arg == "--no-warm-start")
+            {
+                options.warm_start = false;
+            }
+            else if (arg == "--stats")
+            {
+                print_search_stats = true;
+            }
+            else if (key == "--time-limit")
+            {
+                large_options.time_limit = std::stod(value);
+                options.time_limit = large_options.time_limit;
+            }
+            else if (key == "--node-limit")
+            {
+                options.node_limit = std::stoul(value);
+            }
+            else if (key == "--neighbours")
+            {
+                large_options.n_neighbours = std::stoul(value);
+            }
+            else if (key == "--seed")
+            {
+                large_options.seed = static_cast<unsigned>(std::stoul(value));
+            }
+            else if (arg.rfind("--", 0) != 0 && path.empty())
+            {
+                path = arg;
+            }
+            else
+            {
+                print_usage(argv[0]);
+                return EXIT_FAILURE;
+            }
         }
-        std::cout << "\n";
     }
+    catch (const std::exception &)
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (path.empty())
+    {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        const tsplib_instance_t instance = load_tsplib(path);
+        if (heuristic)
+        {
+            // Rounded Euclidean distances are computed on demand, without a matrix.
+            if (instance.weight_type == tsplib_weight_type_t::Euc2D)
+            {
+                print_solution(solve_tsp_large(PointDistances(instance.points, rounding_t::Nearest), large_options));
+            }
+            else if (instance.weight_type == tsplib_weight_type_t::Ceil2D)
+            {
+                print_solution(solve_tsp_large(PointDistances(instance.points, rounding_t::Up), large_options));
+            }
+            else
+            {
+                print_solution(solve_tsp_large(get_cost_matrix(instance), large_options));
+            }
+            return EXIT_SUCCESS;
+        }
 
+        const OneTreeBound one_tree;
+        const AssignmentBound assignment;
+        if (bound_name == "one-tree")
+        {
+            options.bound = &one_tree;
+        }
+        else if (bound_name == "assignment")
+        {
+            options.bound = &assignment;
+        }
+        search_stats_t stats;
+        if (print_search_stats)
+        {
+            options.stats = &stats;
+        }
+        search_outcome_t outcome;
+        options.outcome = &outcome;
+        const tsp_solutions_t solutions = solve_tsp(get_cost_matrix(instance), options);
+        if (print_search_stats)
+        {
+            print_stats(stats);
+        }
+        if (!outcome.complete)
+        {
+            std::cerr << "stopped by a limit: lower bound " << outcome.lower_bound << ", gap " << outcome.gap()
+                      << "\n";
+        }
+        std::cout << solutions.size() << "\n";
+        for (const tsp_solution_t &solution : solutions)
+        {
+            print_solution(solution);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
     return EXIT_SUCCESS;
 }
@@ -1,11 +1,22 @@
 #include "TSP.hpp"
+#include "tsp_heuristics.hpp"
+#include "tsp_kernels.hpp"
+#include "tsp_pool.hpp"
+#include "tsp_search.hpp"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
 #include <stack>
 #include <optional>
 #include <iostream>
 #include <vector>
-#include <map>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
 
 std::ostream &operator<<(std::ostream &os, const CostMatrix &cm)
 {
@@ -23,48 +34,417 @@ std::ostream &operator<<(std::ostream &os, const CostMatrix &cm)
     return os;
 }
 
-/* PART 1 */
+/**
+ * Round the row length up to a whole number of cache lines.
+ * @param n
+ * @return The padded row length (in elements).
+ */
+static std::size_t padded_stride(std::size_t n)
+{
+    constexpr std::size_t per_line = CostMatrix::alignment / sizeof(cost_t);
+    return (n + per_line - 1) / per_line * per_line;
+}
 
 /**
- * Create path from unsorted path and last 2x2 cost matrix.
- * @return The vector of consecutive vertex.
+ * Round a number of bytes up to a whole number of cache lines.
+ * @param bytes
+ * @return The padded number of bytes.
  */
-path_t StageState::get_path()
+static std::size_t padded_bytes(std::size_t bytes)
 {
-    // Get two last nodes
-    reduce_cost_matrix();
-    cost_matrix_t matrix = get_matrix().get_matrix();
-    for (size_t i = 0; i < matrix.size(); ++i)
+    return (bytes + CostMatrix::alignment - 1) / CostMatrix::alignment * CostMatrix::alignment;
+}
+
+/**
+ * Update a cached minimum after one of the values in its line changed.
+ * @param min The cached minimum.
+ * @param dirty Set if the minimum can no longer be told without a rescan.
+ * @param old_value
+ * @param new_value
+ */
+static void update_min(cost_t &min, unsigned char &dirty, cost_t old_value, cost_t new_value)
+{
+    if (dirty)
+    {
+        return;
+    }
+    if (new_value < min)
+    {
+        min = new_value;
+    }
+    else if (old_value == min && new_value != old_value)
+    {
+        dirty = 1;
+    }
+}
+
+CostMatrix::CostMatrix(const cost_matrix_t &m)
+{
+    allocate(m.size());
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        std::copy(m[r].cbegin(), m[r].cend(), row(r));
+    }
+}
+
+CostMatrix::CostMatrix(std::size_t n, cost_t value)
+{
+    allocate(n);
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        std::fill(row(r), row(r) + size_, value);
+    }
+}
+
+/**
+ * Create a matrix whose buffer is borrowed from the pool.
+ * @param m
+ * @param pool A pool for matrices at least as large as m.
+ */
+CostMatrix::CostMatrix(const cost_matrix_t &m, MatrixPool &pool)
+{
+    if (m.size() > pool.matrix_size())
+    {
+        throw std::invalid_argument("CostMatrix: the matrix does not fit into the pool buffers");
+    }
+    pool_ = &pool;
+    allocate(m.size());
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        std::copy(m[r].cbegin(), m[r].cend(), row(r));
+    }
+}
+
+CostMatrix::CostMatrix(const CostMatrix &other)
+    : size_(other.size_), stride_(other.stride_), minima_stale_(other.minima_stale_)
+{
+    attach(other.pool_ != nullptr ? other.capacity_ : other.size_, other.pool_);
+    if (data_ != nullptr)
+    {
+        std::memcpy(data_, other.data_, size_ * stride_ * sizeof(cost_t));
+        std::copy(other.row_min_, other.row_min_ + size_, row_min_);
+        std::copy(other.col_min_, other.col_min_ + size_, col_min_);
+        std::copy(other.row_dirty_, other.row_dirty_ + size_, row_dirty_);
+        std::copy(other.col_dirty_, other.col_dirty_ + size_, col_dirty_);
+    }
+}
+
+CostMatrix::CostMatrix(CostMatrix &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+CostMatrix &CostMatrix::operator=(const CostMatrix &other)
+{
+    if (this != &other)
+    {
+        *this = CostMatrix(other);
+    }
+    return *this;
+}
+
+CostMatrix &CostMatrix::operator=(CostMatrix &&other) noexcept
+{
+    std::swap(size_, other.size_);
+    std::swap(stride_, other.stride_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(pool_, other.pool_);
+    std::swap(data_, other.data_);
+    std::swap(row_min_, other.row_min_);
+    std::swap(col_min_, other.col_min_);
+    std::swap(row_dirty_, other.row_dirty_);
+    std::swap(col_dirty_, other.col_dirty_);
+    std::swap(minima_stale_, other.minima_stale_);
+    return *this;
+}
+
+CostMatrix::~CostMatrix()
+{
+    release();
+}
+
+/**
+ * The size of a buffer holding a matrix of the given size (padded rows
+ * followed by the cached minima of its rows and columns).
+ * @param capacity The size of the largest matrix the buffer has to hold.
+ * @return The number of bytes (a multiple of the alignment).
+ */
+std::size_t CostMatrix::block_bytes(std::size_t capacity)
+{
+    return padded_bytes(capacity * padded_stride(capacity) * sizeof(cost_t)
+                        + 2 * capacity * sizeof(cost_t) + 2 * capacity);
+}
+
+/**
+ * Take a buffer for matrices up to the given size, from the pool if there is one.
+ * @param capacity
+ * @param pool
+ */
+void CostMatrix::attach(std::size_t capacity, MatrixPool *pool)
+{
+    pool_ = pool;
+    capacity_ = (pool != nullptr) ? pool->matrix_size() : capacity;
+    if (capacity_ == 0)
     {
-        for (size_t j = 0; j < matrix[i].size(); ++j)
+        return;
+    }
+    void *block;
+    if (pool != nullptr)
+    {
+        block = pool->acquire();
+    }
+    else
+    {
+        block = std::aligned_alloc(alignment, block_bytes(capacity_));
+        if (block == nullptr)
         {
-            if (matrix[i][j] == 0)
+            throw std::bad_alloc();
+        }
+    }
+    data_ = static_cast<cost_t *>(block);
+    row_min_ = data_ + capacity_ * padded_stride(capacity_);
+    col_min_ = row_min_ + capacity_;
+    row_dirty_ = reinterpret_cast<unsigned char *>(col_min_ + capacity_);
+    col_dirty_ = row_dirty_ + capacity_;
+}
+
+/**
+ * Give the buffer back.
+ */
+void CostMatrix::release()
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+    if (pool_ != nullptr)
+    {
+        pool_->release(data_);
+    }
+    else
+    {
+        std::free(data_);
+    }
+    data_ = nullptr;
+}
+
+/**
+ * Allocate an n x n buffer with every cell (padding included) set to INF.
+ * @param n
+ */
+void CostMatrix::allocate(std::size_t n)
+{
+    size_ = n;
+    stride_ = padded_stride(n);
+    attach(n, pool_);
+    std::fill(data_, data_ + size_ * stride_, INF);
+    std::fill(row_min_, row_min_ + size_, INF);
+    std::fill(col_min_, col_min_ + size_, INF);
+    std::fill(row_dirty_, row_dirty_ + size_, 0);
+    std::fill(col_dirty_, col_dirty_ + size_, 0);
+    minima_stale_ = true;
+}
+
+/**
+ * Copy the matrix into the nested vector representation.
+ * @return The cost matrix as a vector of rows.
+ */
+cost_matrix_t CostMatrix::get_matrix() const
+{
+    cost_matrix_t m(size_);
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        m[r].assign(row(r), row(r) + size_);
+    }
+    return m;
+}
+
+/**
+ * @return The number of bytes taken by the matrix and its cached minima.
+ */
+std::size_t CostMatrix::memory_usage() const
+{
+    return sizeof(CostMatrix) + block_bytes(capacity_);
+}
+
+/**
+ * Set a single cell, marking its row and column for a rescan if needed.
+ * @param r
+ * @param c
+ * @param value
+ */
+void CostMatrix::set(std::size_t r, std::size_t c, cost_t value)
+{
+    cost_t &cell = row(r)[c];
+    const cost_t old_value = cell;
+    cell = value;
+    if (!minima_stale_)
+    {
+        update_min(row_min_[r], row_dirty_[r], old_value, value);
+        update_min(col_min_[c], col_dirty_[c], old_value, value);
+    }
+}
+
+/**
+ * Remove a row and a column, so that the matrix shrinks by one.
+ * Rows and columns which had their minimum in the removed ones are marked
+ * for a rescan.
+ * @param r
+ * @param c
+ */
+void CostMatrix::erase(std::size_t r, std::size_t c)
+{
+    if (!minima_stale_)
+    {
+        for (std::size_t i = 0; i < size_; ++i)
+        {
+            if (!row_dirty_[i] && row(i)[c] == row_min_[i])
             {
-                unsorted_path_.push_back(vertex_t(i, j));
+                row_dirty_[i] = 1;
+            }
+            if (!col_dirty_[i] && row(r)[i] == col_min_[i])
+            {
+                col_dirty_[i] = 1;
             }
         }
     }
-    // Sort unsorted path
-    std::map<size_t, size_t> m;
-    size_t second;
 
-    for (auto el : unsorted_path_)
+    // Rows only move towards the beginning of the buffer, so they can be
+    // compacted in place.
+    const std::size_t n = size_ - 1;
+    const std::size_t stride = padded_stride(n);
+    for (std::size_t i = 0, k = 0; i < size_; ++i)
     {
-        m.insert(std::pair<size_t, size_t>(el.row, el.col));
-        if (el.row == 0)
+        if (i == r)
         {
-            second = el.col;
+            continue;
         }
+        const cost_t *src = row(i);
+        cost_t *dst = data_ + k * stride;
+        std::memmove(dst, src, c * sizeof(cost_t));
+        std::memmove(dst + c, src + c + 1, (size_ - c - 1) * sizeof(cost_t));
+        std::fill(dst + n, dst + stride, INF);
+        ++k;
     }
-    path_t result({0, second});
+    std::copy(row_min_ + r + 1, row_min_ + size_, row_min_ + r);
+    std::copy(row_dirty_ + r + 1, row_dirty_ + size_, row_dirty_ + r);
+    std::copy(col_min_ + c + 1, col_min_ + size_, col_min_ + c);
+    std::copy(col_dirty_ + c + 1, col_dirty_ + size_, col_dirty_ + c);
+    size_ = n;
+    stride_ = stride;
+}
 
-    while (m[second] != 0)
+/**
+ * Subtract a value from every finite cell of each row and each column (which
+ * must leave no cell negative). The cached minima are recomputed on demand.
+ * @param row_values The value for every row.
+ * @param col_values The value for every column.
+ */
+void CostMatrix::subtract(const std::vector<cost_t> &row_values, const std::vector<cost_t> &col_values)
+{
+    for (std::size_t r = 0; r < size_; ++r)
     {
-        result.push_back(m[second] + 1);
-        second = m[second];
+        cost_t *cells = row(r);
+        for (std::size_t c = 0; c < size_; ++c)
+        {
+            if (!is_inf(cells[c]))
+            {
+                cells[c] = static_cast<cost_t>(cells[c] - row_values[r] - col_values[c]);
+            }
+        }
+    }
+    minima_stale_ = true;
+}
+
+/**
+ * Recompute all cached minima (in a single row-major pass) if the matrix has
+ * been written through operator[].
+ */
+void CostMatrix::refresh_minima()
+{
+    if (!minima_stale_)
+    {
+        return;
+    }
+    const cost_kernels_t &kernels = get_cost_kernels();
+    std::fill(col_min_, col_min_ + size_, INF);
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        row_min_[r] = kernels.row_min_accumulate(row(r), size_, col_min_);
+    }
+    std::fill(row_dirty_, row_dirty_ + size_, 0);
+    std::fill(col_dirty_, col_dirty_ + size_, 0);
+    minima_stale_ = false;
+}
+
+/**
+ * Scan a column for its minimum.
+ * @param c
+ * @return The minimum value in the column.
+ */
+cost_t CostMatrix::col_min(std::size_t c) const
+{
+    cost_t min = INF;
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        min = std::min(min, row(r)[c]);
+    }
+    return min;
+}
+
+/* PART 1 */
+
+/**
+ * Create path from unsorted path and last 2x2 cost matrix.
+ * @return The vector of consecutive vertex, or an empty path if the stage
+ *         cannot be closed into a tour.
+ */
+path_t StageState::get_path()
+{
+    // Get two last nodes
+    reduce_cost_matrix();
+    if (rows_.size() != 2 || cols_.size() != 2)
+    {
+        return {};
+    }
+    const std::size_t r0 = local_row(rows_[0]);
+    const std::size_t r1 = local_row(rows_[1]);
+    const std::size_t c0 = local_col(cols_[0]);
+    const std::size_t c1 = local_col(cols_[1]);
+
+    // Subtours are forbidden, so at most one way of closing the tour is left.
+    const CostMatrix &m = matrix_;
+    const bool straight = !is_inf(m[r0][c0]) && !is_inf(m[r1][c1]);
+    const bool crossed = !is_inf(m[r0][c1]) && !is_inf(m[r1][c0]);
+    if (straight && (!crossed || static_cast<cost_sum_t>(m[r0][c0]) + m[r1][c1] <=
+                                 static_cast<cost_sum_t>(m[r0][c1]) + m[r1][c0]))
+    {
+        unsorted_path_.push_back(vertex_t(rows_[0], cols_[0]));
+        unsorted_path_.push_back(vertex_t(rows_[1], cols_[1]));
+    }
+    else if (crossed)
+    {
+        unsorted_path_.push_back(vertex_t(rows_[0], cols_[1]));
+        unsorted_path_.push_back(vertex_t(rows_[1], cols_[0]));
+    }
+    else
+    {
+        return {};
+    }
+    rows_.clear();
+    cols_.clear();
+
+    // Follow the successor of every city, starting from the first one.
+    std::vector<std::size_t> next(unsorted_path_.size());
+    for (const auto &v : unsorted_path_)
+    {
+        next[v.row] = v.col;
+    }
+    path_t result({1});
+    for (std::size_t city = next[0]; city != 0; city = next[city])
+    {
+        result.push_back(city + 1);
     }
-    result[0] += 1;
-    result[1] += 1;
 
     return result;
 }
@@ -76,31 +456,49 @@ path_t StageState::get_path()
 std::vector<cost_t> CostMatrix::get_min_values_in_rows() const
 {
     std::vector<cost_t> result;
-    for (auto v : matrix_)
+    for (std::size_t r = 0; r < size_; ++r)
     {
-        result.push_back(*std::min_element(v.begin(), v.end()));
+        if (!minima_stale_ && !row_dirty_[r])
+        {
+            result.push_back(row_min_[r]);
+        }
+        else
+        {
+            result.push_back(get_cost_kernels().row_min(row(r), size_));
+        }
     };
     return result;
 }
 
 /**
  * Reduce rows so that in each row at least one zero value is present.
+ * Only rows whose cached minimum is not known to be zero are touched, and
+ * rows consisting of INF only are left untouched.
  * @return Sum of values reduced in rows.
  */
 cost_t CostMatrix::reduce_rows()
 {
-    const std::vector<cost_t> min_values = get_min_values_in_rows();
-    for (size_t j = 0; j < matrix_.size(); ++j)
+    refresh_minima();
+    const cost_kernels_t &kernels = get_cost_kernels();
+    cost_t reduced = 0;
+    for (std::size_t r = 0; r < size_; ++r)
     {
-        for (int &el : matrix_[j])
+        if (row_dirty_[r])
         {
-            if (el != INF)
-            {
-                el -= min_values[j];
-            }
+            row_min_[r] = kernels.row_min(row(r), size_);
+            row_dirty_[r] = 0;
+        }
+        const cost_t min = row_min_[r];
+        if (min == 0 || is_inf(min))
+        {
+            continue;
         }
+        // Lowering the minima of dirty columns is harmless, they get rescanned anyway.
+        kernels.row_subtract(row(r), size_, min, col_min_);
+        row_min_[r] = 0;
+        reduced = add_costs(reduced, min);
     }
-    return std::accumulate(min_values.cbegin(), min_values.cend(), 0);
+    return reduced;
 }
 
 /**
@@ -109,188 +507,411 @@ cost_t CostMatrix::reduce_rows()
  */
 std::vector<cost_t> CostMatrix::get_min_values_in_cols() const
 {
-    std::vector<cost_t> min_values(matrix_.size(), INF);
-    for (size_t i = 0; i < matrix_.size(); ++i)
+    std::vector<cost_t> min_values(size_, INF);
+    if (minima_stale_)
     {
-        for (size_t j = 0; j < matrix_[i].size(); ++j)
+        // Accumulate the minima row by row rather than walking down the columns.
+        const cost_kernels_t &kernels = get_cost_kernels();
+        for (std::size_t r = 0; r < size_; ++r)
         {
-            if (matrix_[j][i] < min_values[i])
-            {
-                min_values[i] = matrix_[j][i];
-            }
+            kernels.row_min_accumulate(row(r), size_, min_values.data());
         }
-    };
+        return min_values;
+    }
+    for (std::size_t c = 0; c < size_; ++c)
+    {
+        min_values[c] = col_dirty_[c] ? col_min(c) : col_min_[c];
+    }
     return min_values;
 }
 
 /**
  * Reduces rows so that in each column at least one zero value is present.
+ * Only columns whose cached minimum is not known to be zero are touched, and
+ * columns consisting of INF only are left untouched.
  * @return Sum of values reduced in columns.
  */
 cost_t CostMatrix::reduce_cols()
 {
-    const std::vector<cost_t> min_values = get_min_values_in_cols();
-    for (size_t i = 0; i < matrix_.size(); ++i)
+    refresh_minima();
+    const std::size_t n_dirty = static_cast<std::size_t>(std::count(col_dirty_, col_dirty_ + size_, 1));
+    if (n_dirty * 8 > size_)
     {
-        for (size_t j = 0; j < matrix_[i].size(); ++j)
+        return reduce_cols_rowwise();
+    }
+
+    // Few columns to rescan: walking down each of them is cheaper than a full pass.
+    cost_t reduced = 0;
+    for (std::size_t c = 0; c < size_; ++c)
+    {
+        if (col_dirty_[c])
+        {
+            col_min_[c] = col_min(c);
+            col_dirty_[c] = 0;
+        }
+        const cost_t min = col_min_[c];
+        if (min == 0 || is_inf(min))
+        {
+            continue;
+        }
+        for (std::size_t r = 0; r < size_; ++r)
         {
-            if (matrix_[j][i] != INF)
+            cost_t &cell = row(r)[c];
+            if (!is_inf(cell))
             {
-                matrix_[j][i] -= min_values[i];
+                cell -= min;
+                if (!row_dirty_[r] && cell < row_min_[r])
+                {
+                    row_min_[r] = cell;
+                }
             }
         }
+        col_min_[c] = 0;
+        reduced = add_costs(reduced, min);
     }
-    return std::accumulate(min_values.cbegin(), min_values.cend(), 0);
+    return reduced;
+}
+
+/**
+ * Reduce the columns with two row-major passes: one accumulating the column
+ * minima, one subtracting them (which also gives the new row minima).
+ * @return Sum of values reduced in columns.
+ */
+cost_t CostMatrix::reduce_cols_rowwise()
+{
+    const cost_kernels_t &kernels = get_cost_kernels();
+    // Reused between calls, so that the search does not allocate here.
+    static thread_local std::vector<cost_t> min_values;
+    min_values.assign(size_, INF);
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        kernels.row_min_accumulate(row(r), size_, min_values.data());
+    }
+
+    cost_t reduced = 0;
+    bool changed = false;
+    for (std::size_t c = 0; c < size_; ++c)
+    {
+        col_dirty_[c] = 0;
+        if (is_inf(min_values[c]))
+        {
+            col_min_[c] = INF;
+            min_values[c] = 0;
+        }
+        else
+        {
+            col_min_[c] = 0;
+            reduced = add_costs(reduced, min_values[c]);
+            changed = changed || min_values[c] != 0;
+        }
+    }
+    if (!changed)
+    {
+        return 0;
+    }
+
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        row_min_[r] = kernels.row_subtract_each(row(r), size_, min_values.data());
+        row_dirty_[r] = 0;
+    }
+    return reduced;
 }
 
 /**
  * Get the cost of not visiting the vertex_t (@see: get_new_vertex())
  * @param row
  * @param col
- * @return The sum of minimal values in row and col, excluding the intersection value.
+ * @return The sum of minimal values in row and col, excluding the intersection value
+ *         (INF if the row or the column has no other finite value).
  */
 cost_t CostMatrix::get_vertex_cost(std::size_t row, std::size_t col) const
 {
     cost_t min_row_val = INF;
     cost_t min_col_val = INF;
-    for (size_t i = 0; i < matrix_.size(); ++i)
+    for (size_t i = 0; i < size_; ++i)
     {
         if (i != row)
         {
-            if (matrix_[i][col] < min_col_val)
+            if ((*this)[i][col] < min_col_val)
             {
-                min_col_val = matrix_[i][col];
+                min_col_val = (*this)[i][col];
             }
         }
     }
 
-    for (size_t i = 0; i < matrix_.size(); ++i)
+    for (size_t i = 0; i < size_; ++i)
     {
         if (i != col)
         {
-            if (matrix_[row][i] < min_row_val)
+            if ((*this)[row][i] < min_row_val)
+            {
+                min_row_val = (*this)[row][i];
+            }
+        }
+    }
+    return add_costs(min_row_val, min_col_val);
+}
+
+/**
+ * Find the two smallest values of every row and column in a single row-major
+ * pass, so that the cost of any vertex can be told in O(1) (@see: get_vertex_cost()).
+ * A value is added to a (first, second) pair branch-free as
+ * second = min(second, max(first, v)), first = min(first, v).
+ * @param minima The output (resized to the matrix size).
+ */
+void CostMatrix::get_two_smallest_values(line_minima_t &minima) const
+{
+    minima.row_first.assign(size_, INF);
+    minima.row_second.assign(size_, INF);
+    minima.col_first.assign(size_, INF);
+    minima.col_second.assign(size_, INF);
+    const cost_kernels_t &kernels = get_cost_kernels();
+    for (std::size_t r = 0; r < size_; ++r)
+    {
+        kernels.two_smallest(row(r), size_, minima.row_first[r], minima.row_second[r],
+                             minima.col_first.data(), minima.col_second.data());
+    }
+}
+
+/* PART 2 */
+
+StageState::StageState(const CostMatrix &m, std::vector<vertex_t> p, cost_t lb, Layout layout)
+    : matrix_(m), unsorted_path_(std::move(p)), lower_bound_(lb), layout_(layout), fragments_(m.size())
+{
+    for (std::size_t city = 0; city < m.size(); ++city)
+    {
+        fragments_[city] = {city, city};
+    }
+    std::vector<bool> row_used(m.size(), false);
+    std::vector<bool> col_used(m.size(), false);
+    for (const auto &v : unsorted_path_)
+    {
+        row_used[v.row] = true;
+        col_used[v.col] = true;
+        link(v);
+    }
+    for (std::size_t i = 0; i < m.size(); ++i)
+    {
+        if (!row_used[i])
+        {
+            rows_.push_back(i);
+        }
+        if (!col_used[i])
+        {
+            cols_.push_back(i);
+        }
+    }
+
+    if (layout_ == Layout::Shrinking && !unsorted_path_.empty())
+    {
+        // Keep only the rows and columns that are still to be chosen.
+        CostMatrix compact(rows_.size(), INF);
+        for (std::size_t i = 0; i < rows_.size(); ++i)
+        {
+            for (std::size_t j = 0; j < cols_.size(); ++j)
             {
-                min_row_val = matrix_[row][i];
+                compact[i][j] = m[rows_[i]][cols_[j]];
             }
         }
+        matrix_ = std::move(compact);
+    }
+}
+
+/**
+ * Map a row of the original matrix to a row of the stage matrix.
+ * @param row
+ * @return The row in the stage matrix (npos if the row has been removed).
+ */
+std::size_t StageState::local_row(std::size_t row) const
+{
+    if (layout_ == Layout::Full)
+    {
+        return row;
+    }
+    auto it = std::find(rows_.cbegin(), rows_.cend(), row);
+    return it == rows_.cend() ? npos : static_cast<std::size_t>(it - rows_.cbegin());
+}
+
+/**
+ * Map a column of the original matrix to a column of the stage matrix.
+ * @param col
+ * @return The column in the stage matrix (npos if the column has been removed).
+ */
+std::size_t StageState::local_col(std::size_t col) const
+{
+    if (layout_ == Layout::Full)
+    {
+        return col;
+    }
+    auto it = std::find(cols_.cbegin(), cols_.cend(), col);
+    return it == cols_.cend() ? npos : static_cast<std::size_t>(it - cols_.cbegin());
+}
+
+/**
+ * Map a cell of the stage matrix to the vertex of the original matrix.
+ * @param row
+ * @param col
+ * @return The vertex in the original matrix.
+ */
+vertex_t StageState::to_global(std::size_t row, std::size_t col) const
+{
+    if (layout_ == Layout::Full)
+    {
+        return vertex_t(row, col);
     }
-    return min_row_val + min_col_val;
+    return vertex_t(rows_[row], cols_[col]);
 }
 
-/* PART 2 */
-
 /**
  * Choose next vertex to visit:
  * - Look for vertex_t (pair row and column) with value 0 in the current cost matrix.
- * - Get the vertex_t cost (calls get_vertex_cost()).
+ * - Get the vertex_t cost (the second smallest values of its row and column,
+ *   as given by get_two_smallest_values(); same as get_vertex_cost()).
  * - Choose the vertex_t with maximum cost and returns it.
  * @param cm
- * @return The coordinates of the next vertex.
+ * @return The coordinates (in the original matrix) of the next vertex
+ *         (with cost -INF if the matrix has no zero).
  */
 NewVertex StageState::choose_new_vertex()
 {
-    CostMatrix matrix = get_matrix();
-    cost_matrix_t m = matrix.get_matrix();
+    const CostMatrix &m = matrix_;
+    // Reused between calls, so that the search does not allocate here.
+    static thread_local line_minima_t minima;
+    m.get_two_smallest_values(minima);
+
     std::pair<vertex_t, cost_t> result({0, 0}, -INF);
     // New Vertex - cords, cost
     for (size_t i = 0; i < m.size(); ++i)
     {
+        if (minima.row_first[i] > 0)
+        {
+            continue;
+        }
+        // Leaving out the zero itself: if it is the smallest value, the second one takes its place.
+        const cost_t row_cost = minima.row_first[i] == 0 ? minima.row_second[i] : minima.row_first[i];
         for (size_t j = 0; j < m.size(); ++j)
         {
-            // std::cout << m[i][j] << " ";
             if (m[i][j] == 0)
             {
-                cost_t vert_cost = matrix.get_vertex_cost(i, j);
+                const cost_t col_cost = minima.col_first[j] == 0 ? minima.col_second[j] : minima.col_first[j];
+                cost_t vert_cost = add_costs(row_cost, col_cost);
                 if (vert_cost > result.second)
                 {
                     result = std::pair<vertex_t, cost_t>(vertex_t(i, j), vert_cost);
                 }
             }
         }
-        // std::cout << std::endl;
     }
-    return NewVertex(vertex_t(result.first.row, result.first.col), result.second);
+    return NewVertex(to_global(result.first.row, result.first.col), result.second);
 }
 
-std::pair<size_t, size_t> get_begin_end_from_path(unsorted_path_t unsorted_path_)
+/**
+ * Join the fragments ending at the row and starting at the column of the vertex.
+ * @param v A vertex whose row is not left and whose column is not entered yet.
+ * @return The vertex going from the end of the joined fragment back to its beginning.
+ */
+vertex_t StageState::link(vertex_t v)
 {
-    std::vector<size_t> begins({});
-    std::vector<size_t> ends({});
-    // std::cout << "Start function!" << std::endl;
-
-    // Wyznaczamy poczatek i koniec sciezki
-    for (auto vert : unsorted_path_)
-    {
-        // Sprawdzamy czy poczatek iterowanego wektora jest w koncach
-        auto res1 = std::find(ends.cbegin(), ends.cend(), vert.row);
-
-        // Jezeli poczatek jest w koncach usuwamy go
-        if (res1 != ends.end())
-        {
-            ends.erase(res1);
-        }
-        else
-        {
-            begins.push_back(vert.row);
-        }
-        // Sprawdzamy czy koniec iterowanego wektora jest w poczatkach
-        auto res2 = std::find(begins.cbegin(), begins.cend(), vert.col);
+    const std::size_t first = fragments_[v.row].first;
+    const std::size_t last = fragments_[v.col].last;
+    fragments_[first].last = last;
+    fragments_[last].first = first;
+    return vertex_t(last, first);
+}
 
-        // Jezeli koniec jest w poczatkach usuwamy go
-        if (res2 != begins.end())
-        {
-            begins.erase(res2);
-        }
-        else
-        {
-            ends.push_back(vert.col);
-        }
-        // std::cout << "End of loop!" << std::endl;
-    }
-    // std::cout << "Begin: " << begins[0] << std::endl;
-    // std::cout << "End: " << ends[0] << std::endl;
-    // std::cout << "Begin size: " << begins.size() << std::endl;
-    // std::cout << "End size: " << ends.size() << std::endl;
-    std::pair<size_t, size_t> res(begins[0], ends[0]);
-    return res;
+/**
+ * Remove a row and a column from a shrinking stage matrix.
+ * @param row The row in the stage matrix.
+ * @param col The column in the stage matrix.
+ */
+void StageState::remove_row_col(std::size_t row, std::size_t col)
+{
+    matrix_.erase(row, col);
+    rows_.erase(rows_.begin() + static_cast<std::ptrdiff_t>(row));
+    cols_.erase(cols_.begin() + static_cast<std::ptrdiff_t>(col));
 }
 
 /**
  * Update the cost matrix with the new vertex.
- * @param new_vertex
+ * @param new_vertex The vertex (in the original matrix) added to the path.
  */
 void StageState::update_cost_matrix(vertex_t new_vertex)
 {
-    cost_matrix_t matrix = matrix_.get_matrix();
-    // Blokujemy przejescie przez odpowiednia kolumne i wiersz
-    for (size_t i = 0; i < matrix.size(); ++i)
+    // Going from the end of the fragment back to its beginning would close a subtour.
+    forbid(link(new_vertex));
+
+    const std::size_t row = local_row(new_vertex.row);
+    const std::size_t col = local_col(new_vertex.col);
+    if (layout_ == Layout::Shrinking)
     {
-        matrix[i][new_vertex.col] = INF;
-        matrix[new_vertex.row][i] = INF;
+        remove_row_col(row, col);
+        return;
     }
 
-    std::pair<size_t, size_t> result = get_begin_end_from_path(unsorted_path_);
-
-    // [(0, 2), (3, 0)] -> 3, 2
-    size_t begin = result.first;
-    size_t end = result.second;
+    // Blokujemy przejescie przez odpowiednia kolumne i wiersz
+    for (size_t i = 0; i < matrix_.size(); ++i)
+    {
+        matrix_.set(i, col, INF);
+        matrix_.set(row, i, INF);
+    }
+    rows_.erase(std::find(rows_.begin(), rows_.end(), new_vertex.row));
+    cols_.erase(std::find(cols_.begin(), cols_.end(), new_vertex.col));
+}
 
-    // Jezeli poczatek nowego wektora to koniec naszego path'a to znaczy ze dodajemy go na koniec.
-    // Czyli usuwamy przejscie z konca naszego nowego wektora na poczatek path'a
-    if (new_vertex.row == end)
+/**
+ * Forbid the vertex (if its row and column are still in the stage matrix).
+ * @param v The vertex in the original matrix.
+ */
+void StageState::forbid(vertex_t v)
+{
+    const std::size_t row = local_row(v.row);
+    const std::size_t col = local_col(v.col);
+    if (row != npos && col != npos)
     {
-        // Dodajemy na koniec
-        matrix[new_vertex.col][begin] = INF;
+        matrix_.set(row, col, INF);
     }
-    else if (new_vertex.col == begin)
+}
+
+/**
+ * Reduce the stage matrix by dual potentials (the reduced cost of every cell
+ * staying non-negative) and add their sum to the lower bound (INF if the sum
+ * reaches INF).
+ * @param row_values The potential of every row of the stage matrix.
+ * @param col_values The potential of every column of the stage matrix.
+ */
+void StageState::apply_potentials(const std::vector<cost_t> &row_values, const std::vector<cost_t> &col_values)
+{
+    // The negative potentials are summed first, so that the partial sums only
+    // grow and saturate at INF exactly when the whole sum reaches it.
+    const cost_sum_t inf = static_cast<cost_sum_t>(INF);
+    cost_sum_t sum = 0;
+    for (bool negative : {true, false})
     {
-        // Dodajemy na poczatek
-        matrix[end][new_vertex.row] = INF;
+        for (std::size_t k = 0; k < matrix_.size(); ++k)
+        {
+            for (cost_t value : {row_values[k], col_values[k]})
+            {
+                if ((value < 0) == negative)
+                {
+                    sum = (value > 0 && sum >= inf - value) ? inf : sum + value;
+                }
+            }
+        }
     }
-    matrix[new_vertex.col][new_vertex.row] = INF;
-    matrix[end][begin] = INF;
-    // Update Cost Matrix
-    matrix_ = CostMatrix(matrix);
+    matrix_.subtract(row_values, col_values);
+    update_lower_bound(static_cast<cost_t>(sum));
+}
+
+/**
+ * @return The number of bytes taken by the stage.
+ */
+std::size_t StageState::memory_usage() const
+{
+    return sizeof(StageState) - sizeof(CostMatrix) + matrix_.memory_usage()
+           + unsorted_path_.capacity() * sizeof(vertex_t)
+           + (rows_.capacity() + cols_.capacity()) * sizeof(std::size_t)
+           + fragments_.capacity() * sizeof(fragment_ends_t);
 }
 
 /**
@@ -299,14 +920,15 @@ void StageState::update_cost_matrix(vertex_t new_vertex)
  */
 cost_t StageState::reduce_cost_matrix()
 {
-    return matrix_.reduce_cols() + matrix_.reduce_rows();
+    const cost_t reduced = matrix_.reduce_cols();
+    return add_costs(reduced, matrix_.reduce_rows());
 }
 
 /**
  * Given the optimal path, return the optimal cost.
  * @param optimal_path
  * @param m
- * @return Cost of the path.
+ * @return Cost of the path (INF if it has a forbidden transition or costs at least INF).
  */
 cost_t get_optimal_cost(const path_t &optimal_path, const cost_matrix_t &m)
 {
@@ -314,27 +936,96 @@ cost_t get_optimal_cost(const path_t &optimal_path, const cost_matrix_t &m)
 
     for (std::size_t idx = 1; idx < optimal_path.size(); ++idx)
     {
-        cost += m[optimal_path[idx - 1] - 1][optimal_path[idx] - 1];
+        cost = add_costs(cost, m[optimal_path[idx - 1] - 1][optimal_path[idx] - 1]);
     }
 
     // Add the cost of returning from the last city to the initial one.
-    cost += m[optimal_path[optimal_path.size() - 1] - 1][optimal_path[0] - 1];
+    cost = add_costs(cost, m[optimal_path[optimal_path.size() - 1] - 1][optimal_path[0] - 1]);
 
     return cost;
 }
 
 /**
- * Create the right branch matrix with the chosen vertex forbidden and the new lower bound.
- * @param m
+ * Create the right branch: the parent stage with the chosen vertex forbidden,
+ * reduced again so that its lower bound includes the cost of the exclusion.
+ *
+ * If the reversed tours are skipped (on a symmetric matrix), a right branch
+ * of a stage with an empty path forbids the reverse vertex too: the tours
+ * using it are the reverses of tours using the chosen vertex, all of which
+ * are in the left branch. The stages with an empty path forbid both
+ * directions of every vertex they exclude, so every cycle stays in the tree
+ * in exactly one direction.
+ * @param parent
  * @param v
- * @param lb
  * @return New branch.
  */
-StageState create_right_branch_matrix(cost_matrix_t m, vertex_t v, cost_t lb)
+StageState create_right_branch_matrix(const StageState &parent, vertex_t v)
+{
+    StageState right_branch(parent);
+    right_branch.forbid(v);
+    if (parent.skips_reversed_tours() && parent.get_level() == 0)
+    {
+        right_branch.forbid(vertex_t(v.col, v.row));
+    }
+    right_branch.update_lower_bound(right_branch.reduce_cost_matrix());
+    return right_branch;
+}
+
+/**
+ * Add the statistics of another thread of the same search to these.
+ * @param other
+ */
+void search_stats_t::merge(const search_stats_t &other)
 {
-    CostMatrix cm(m);
-    cm[v.row][v.col] = INF;
-    return StageState(cm, {}, lb);
+    nodes_expanded += other.nodes_expanded;
+    nodes_pruned += other.nodes_pruned;
+    max_depth = std::max(max_depth, other.max_depth);
+    // Every improvement lowers the best cost shared by the threads, so the costs give the order.
+    incumbents.insert(incumbents.end(), other.incumbents.begin(), other.incumbents.end());
+    std::stable_sort(incumbents.begin(), incumbents.end(), [](const incumbent_t &a, const incumbent_t &b)
+                     { return a.cost > b.cost; });
+    reduction_seconds += other.reduction_seconds;
+    bound_seconds += other.bound_seconds;
+    selection_seconds += other.selection_seconds;
+    update_seconds += other.update_seconds;
+    path_seconds += other.path_seconds;
+}
+
+/**
+ * @return The relative difference between the cost of the tours found and the
+ *         lower bound (0 once the search is complete, infinity if it found no tour).
+ */
+double search_outcome_t::gap() const
+{
+    if (complete)
+    {
+        return 0;
+    }
+    if (is_inf(best_cost))
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double diff = static_cast<double>(best_cost) - static_cast<double>(lower_bound);
+    return best_cost == 0 ? 0 : diff / static_cast<double>(best_cost);
+}
+
+/**
+ * @return How much more expensive the heuristic tour is than the optimal one
+ *         (0.05 = 5%; infinity if there is no heuristic tour, 0 if there is no tour at all).
+ */
+double warm_start_report_t::gap() const
+{
+    if (is_inf(optimal_cost))
+    {
+        return 0;
+    }
+    if (is_inf(heuristic_cost))
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double diff = static_cast<double>(heuristic_cost) - static_cast<double>(optimal_cost);
+    return optimal_cost == 0 ? (diff == 0 ? 0 : std::numeric_limits<double>::infinity())
+                             : diff / static_cast<double>(optimal_cost);
 }
 
 /**
@@ -359,6 +1050,175 @@ tsp_solutions_t filter_solutions(tsp_solutions_t solutions)
     return optimal_solutions;
 }
 
+/**
+ * The stage the search starts from: the whole matrix, shrinking as vertices
+ * are added to the path. On a symmetric matrix, every tour is as expensive
+ * as its reverse, so if only one direction is wanted the branches skip the
+ * other one (@see: tsp_options_t::skip_reversed_tours).
+ * @param cm
+ * @param options
+ * @param pool The buffers for the matrices of the search tree.
+ * @return The root of the search tree.
+ */
+StageState get_root_stage(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool)
+{
+    StageState root(CostMatrix(cm, pool), {}, 0, StageState::Layout::Shrinking);
+    if (options.skip_reversed_tours && is_symmetric(cm))
+    {
+        root.skip_reversed_tours();
+    }
+    return root;
+}
+
+/**
+ * Close a leaf stage into a tour.
+ * @param stage A stage for which branch_step() returned Leaf.
+ * @param cm The original cost matrix.
+ * @param best_lb The cost of the best tour found so far.
+ * @param solution Set to the tour if it is at most as expensive as best_lb.
+ * @param stats Where the time taken is recorded.
+ * @return Whether the solution was set.
+ */
+bool close_leaf(StageState &stage, const cost_matrix_t &cm, cost_t best_lb, tsp_solution_t &solution,
+                StatsRecorder stats)
+{
+    const auto start = stats.now();
+    path_t new_path = stage.get_path();
+    cost_t cost = new_path.empty() ? INF : get_optimal_cost(new_path, cm);
+    stats.add_time(&search_stats_t::path_seconds, start);
+    if (new_path.empty() || is_inf(cost) || cost > best_lb)
+    {
+        return false;
+    }
+    solution = {cost, std::move(new_path)};
+    return true;
+}
+
+/**
+ * @param cm
+ * @return Whether every transition costs the same as the one back.
+ */
+bool is_symmetric(const cost_matrix_t &cm)
+{
+    for (std::size_t r = 0; r < cm.size(); ++r)
+    {
+        for (std::size_t c = r + 1; c < cm.size(); ++c)
+        {
+            if (cm[r][c] != cm[c][r])
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @param cost
+ * @return The highest cost below the given one.
+ */
+static cost_t cost_below(cost_t cost)
+{
+    if (std::is_floating_point<cost_t>::value)
+    {
+        return static_cast<cost_t>(std::nextafter(cost, -INF));
+    }
+    return static_cast<cost_t>(cost - 1);
+}
+
+/**
+ * @param cost
+ * @return How much dearer the same tour may come out when its costs are summed
+ *         in another order (a few ULPs for floating-point costs, 0 for integers).
+ */
+static cost_t cost_tolerance(cost_t cost)
+{
+    const double epsilon = static_cast<double>(std::numeric_limits<cost_t>::epsilon());
+    return static_cast<cost_t>(64 * epsilon * std::max(1.0, std::abs(static_cast<double>(cost))));
+}
+
+/**
+ * @param cost
+ * @return The highest cost of a tour as cheap as the given one, i.e. within
+ *         its tolerance (below INF).
+ */
+static cost_t cost_tie_bound(cost_t cost)
+{
+    return std::min(add_costs(cost, cost_tolerance(cost)), cost_below(INF));
+}
+
+/**
+ * @param cost
+ * @return The highest cost of a tour cheaper than the given one, i.e. below its tolerance.
+ */
+static cost_t cost_strictly_below(cost_t cost)
+{
+    return cost_below(static_cast<cost_t>(cost - cost_tolerance(cost)));
+}
+
+/**
+ * Floating-point costs are compared with a tolerance (@see: cost_tolerance()):
+ * the lower bounds of the stages and the costs of the tours come from sums in
+ * different orders, so the same tour may cost a few ULPs more at a leaf than
+ * as the warm start.
+ * @param options The number of tours to keep and the callback.
+ * @param upper_bound The cost of a known tour (INF if none); tours as expensive are still kept.
+ *        Without one, the bound is INF (the stages whose lower bound reached INF are still
+ *        pruned, as a tour costing INF is infeasible; @see: exceeds_bound()).
+ */
+TourCollector::TourCollector(const tsp_options_t &options, cost_t upper_bound)
+    : best_(upper_bound), max_tours_(options.max_tours), on_tour_(options.on_tour),
+      bound_(is_inf(upper_bound) ? INF : cost_tie_bound(upper_bound)) {}
+
+/**
+ * Keep a tour unless it is dearer than the bound.
+ * @param solution
+ * @param branches The branches leading to the leaf of the tour (none if the
+ *        tours are added in the order the depth-first search finds them).
+ * @return Whether the tour is cheaper than all the tours before it.
+ */
+bool TourCollector::add(tsp_solution_t &&solution, std::vector<bool> &&branches)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const cost_t cost = solution.lower_bound;
+    if (cost > bound())
+    {
+        return false;
+    }
+    const bool improved = cost_tie_bound(cost) < best_;
+    if (improved)
+    {
+        tours_.clear();
+    }
+    best_ = std::min(best_, cost);
+    if (on_tour_)
+    {
+        on_tour_(solution);
+    }
+    tours_.push_back({std::move(branches), std::move(solution)});
+    // Once enough tours are kept, only cheaper ones are worth searching for.
+    const bool full = max_tours_ != 0 && tours_.size() >= max_tours_;
+    bound_.store(full ? cost_strictly_below(best_) : cost_tie_bound(best_), std::memory_order_relaxed);
+    return improved;
+}
+
+/**
+ * @return The tours kept, in the order the depth-first search finds them.
+ */
+tsp_solutions_t TourCollector::take()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::stable_sort(tours_.begin(), tours_.end(), [](const found_tour_t &a, const found_tour_t &b)
+                     { return a.branches < b.branches; });
+    tsp_solutions_t solutions;
+    for (found_tour_t &tour : tours_)
+    {
+        solutions.push_back(std::move(tour.solution));
+    }
+    tours_.clear();
+    return solutions;
+}
+
 /**
  * Solve the TSP.
  * @param cm The cost matrix.
@@ -366,8 +1226,35 @@ tsp_solutions_t filter_solutions(tsp_solutions_t solutions)
  */
 tsp_solutions_t solve_tsp(const cost_matrix_t &cm)
 {
+    return solve_tsp(cm, tsp_options_t());
+}
+
+/**
+ * Solve the TSP.
+ * @param cm The cost matrix.
+ * @param options
+ * @return A list of optimal solutions.
+ */
+tsp_solutions_t solve_tsp(const cost_matrix_t &cm, const tsp_options_t &options)
+{
+    MatrixPool pool(cm.size());
+    return solve_tsp(cm, options, pool);
+}
 
-    StageState left_branch(cm);
+/**
+ * Search the tree depth first, copying the matrix of every stage.
+ * @param cm The cost matrix.
+ * @param options The bounding engine, the limits, the statistics, the outcome and the tours to keep.
+ * @param pool The buffers for the matrices of the search tree.
+ * @param upper_bound The cost of a known tour (INF if none).
+ * @return A list of optimal solutions (the best ones found if stopped by a limit).
+ */
+static tsp_solutions_t solve_tsp_depth_first(const cost_matrix_t &cm, const tsp_options_t &options,
+                                             MatrixPool &pool, cost_t upper_bound)
+{
+    StatsRecorder recorder(options.stats);
+    const SearchLimits limits(options);
+    std::size_t n_nodes = 0;
 
     // The branch & bound tree.
     std::stack<StageState> tree_lifo;
@@ -376,66 +1263,254 @@ tsp_solutions_t solve_tsp(const cost_matrix_t &cm)
     // a 2x2 matrix.
     std::size_t n_levels = cm.size() - 2;
 
-    tree_lifo.push(left_branch); // Use the first cost matrix as the root.
+    // Use the first cost matrix as the root; every level drops the chosen row and column.
+    tree_lifo.push(get_root_stage(cm, options, pool));
 
-    cost_t best_lb = INF;
-    tsp_solutions_t solutions;
+    // Tours as expensive as the known one are still searched, so all optimal tours are found.
+    TourCollector tours(options, upper_bound);
+
+    auto push_right = [&tree_lifo, &recorder](StageState &&right_branch)
+    {
+        tree_lifo.push(std::move(right_branch));
+        recorder.waiting(tree_lifo.size());
+    };
 
     while (!tree_lifo.empty())
     {
+        if (limits.reached(n_nodes))
+        {
+            cost_t open_lb = INF;
+            for (; !tree_lifo.empty(); tree_lifo.pop())
+            {
+                open_lb = std::min(open_lb, tree_lifo.top().get_lower_bound());
+            }
+            stop_search(options.outcome, open_lb);
+            break;
+        }
 
-        left_branch = tree_lifo.top();
+        StageState left_branch = std::move(tree_lifo.top());
         tree_lifo.pop();
 
-        while (left_branch.get_level() != n_levels && left_branch.get_lower_bound() <= best_lb)
+        // Repeat until a 2x2 matrix is obtained or the lower bound is too high...
+        step_result_t result;
+        while ((result = branch_step(left_branch, n_levels, tours.bound(), push_right, options.bound, recorder)) ==
+               step_result_t::Branched)
         {
-            // Repeat until a 2x2 matrix is obtained or the lower bound is too high...
+            ++n_nodes;
+        }
 
-            if (left_branch.get_level() == 0)
+        // If the new solution is at least as good as the previous one,
+        // save its cost and its path.
+        tsp_solution_t solution;
+        if (result == step_result_t::Leaf && close_leaf(left_branch, cm, tours.bound(), solution, recorder))
+        {
+            const cost_t cost = solution.lower_bound;
+            if (tours.add(std::move(solution)))
             {
-                left_branch.reset_lower_bound();
+                recorder.incumbent(cost);
             }
+        }
+    }
 
-            // 1. Reduce the matrix in rows and columns.
-            cost_t new_cost = left_branch.reduce_cost_matrix();
+    return tours.take();
+}
 
-            // 2. Update the lower bound and check the break condition.
-            left_branch.update_lower_bound(new_cost);
-            if (left_branch.get_lower_bound() > best_lb)
-            {
-                break;
-            }
+/**
+ * Whether the options pick the Held-Karp engine for the matrix (@see: tsp_engine_t).
+ * @param cm
+ * @param options
+ */
+static bool use_held_karp(const cost_matrix_t &cm, const tsp_options_t &options)
+{
+    return options.engine == tsp_engine_t::HeldKarp ||
+           (options.engine == tsp_engine_t::Auto && cm.size() <= options.held_karp_max_cities &&
+            get_held_karp_bytes(cm.size()) <= options.held_karp_max_bytes);
+}
 
-            // 3. Get new vertex and the cost of not choosing it.
+/**
+ * Whether the warm start is worth finding: it only prunes the tree search,
+ * and is only returned by the Held-Karp engine if a limit stops it.
+ * @param cm
+ * @param options
+ */
+static bool wants_warm_start(const cost_matrix_t &cm, const tsp_options_t &options)
+{
+    const bool limited = options.time_limit > 0 || options.node_limit != 0 || options.cancel != nullptr;
+    return options.warm_start && (!use_held_karp(cm, options) || limited);
+}
 
-            NewVertex new_vertex = left_branch.choose_new_vertex();
+/**
+ * Solve the TSP with the engine chosen by the options, starting from a known tour.
+ * @param cm The cost matrix.
+ * @param options
+ * @param pool
+ * @param seed The tour of the warm start (an empty path if none), returned if
+ *        a limit stops the search before it finds one as cheap.
+ * @param start When the solve started (the time limit includes finding the seed).
+ * @return A list of optimal solutions (@see: solve_tsp()).
+ */
+static tsp_solutions_t solve_tsp_seeded(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool,
+                                        tsp_solution_t seed, std::chrono::steady_clock::time_point start)
+{
+    // The limits and the outcome of the search proper.
+    search_outcome_t outcome;
+    tsp_options_t search_options = options;
+    search_options.outcome = &outcome;
 
-            // 4. @TODO Update the path - use append_to_path method.
-            left_branch.append_to_path(new_vertex.coordinates);
+    if (!seed.path.empty())
+    {
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (options.warm_start_report != nullptr)
+        {
+            options.warm_start_report->heuristic_cost = seed.lower_bound;
+            options.warm_start_report->seconds = seconds;
+        }
+        if (!is_inf(seed.lower_bound))
+        {
+            StatsRecorder(options.stats).incumbent(seed.lower_bound);
+        }
+        if (options.time_limit > 0)
+        {
+            // The search gets what is left, and at least a moment to return the warm start.
+            search_options.time_limit = std::max(options.time_limit - seconds, 1e-9);
+        }
+    }
+    const cost_t upper_bound = seed.path.empty() ? INF : seed.lower_bound;
 
-            // std::cout << new_vertex.coordinates.row << " " << new_vertex.coordinates.col << std::endl;
-            // 5. @TODO (KROK 3) Update the cost matrix of the left branch.
-            left_branch.update_cost_matrix(new_vertex.coordinates);
+    tsp_solutions_t solutions;
+    if (use_held_karp(cm, options))
+    {
+        solutions = solve_tsp_held_karp(cm, search_options);
+    }
+    else if (options.n_threads != 1)
+    {
+        solutions = solve_tsp_parallel(cm, search_options, pool, upper_bound);
+    }
+    else if (options.strategy != search_strategy_t::DepthFirst)
+    {
+        solutions = solve_tsp_best_first(cm, search_options, pool, upper_bound);
+    }
+    else if (options.undo_trail)
+    {
+        solutions = solve_tsp_trail(cm, search_options, upper_bound);
+    }
+    else
+    {
+        solutions = solve_tsp_depth_first(cm, search_options, pool, upper_bound);
+    }
 
-            // 6. Update the right branch and push it to the LIFO.
-            cost_t new_lower_bound = left_branch.get_lower_bound() + new_vertex.cost;
-            tree_lifo.push(create_right_branch_matrix(cm, new_vertex.coordinates,
-                                                      new_lower_bound));
+    // Stopped before reaching a tour as cheap as the warm start (or, should rounding errors
+    // of floating-point costs outgrow their tolerance, the warm start is as good as any).
+    if (solutions.empty() && !is_inf(upper_bound))
+    {
+        if (options.on_tour)
+        {
+            options.on_tour(seed);
         }
+        solutions.push_back(std::move(seed));
+    }
+    outcome.best_cost = solutions.empty() ? INF : solutions.front().lower_bound;
+    outcome.lower_bound = outcome.complete ? outcome.best_cost : std::min(outcome.lower_bound, outcome.best_cost);
+    if (options.outcome != nullptr)
+    {
+        *options.outcome = outcome;
+    }
+
+    if (options.warm_start_report != nullptr)
+    {
+        options.warm_start_report->optimal_cost = outcome.best_cost;
+    }
+    return solutions;
+}
 
-        if (left_branch.get_lower_bound() <= best_lb)
+/**
+ * Solve the TSP with the engine chosen by the options (@see: tsp_engine_t).
+ * @param cm The cost matrix.
+ * @param options
+ * @param pool The buffers for the matrices of the search tree (for matrices at least as large as cm).
+ * @return A list of optimal solutions (the best tours found if a limit stopped the search; @see: tsp_options_t::outcome).
+ */
+tsp_solutions_t solve_tsp(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool)
+{
+    if (cm.size() < 2)
+    {
+        return {};
+    }
+    const auto start = std::chrono::steady_clock::now();
+    tsp_solution_t heuristic{INF, {}};
+    if (wants_warm_start(cm, options))
+    {
+        heuristic = get_heuristic_solution(cm);
+    }
+    return solve_tsp_seeded(cm, options, pool, std::move(heuristic), start);
+}
+
+/**
+ * Solve the TSP again after some costs changed. The cheapest of the previous
+ * tours under the new costs, improved by the local search of the heuristics,
+ * takes the place of the warm start, so the search prunes as well as it did
+ * before the change if the tours stay good (the heuristics only run if none
+ * of them is a tour any more).
+ * @param cm The cost matrix the previous tours were found for; the changes are applied to it.
+ * @param changes
+ * @param previous The tours found for the matrix before the changes (e.g. by solve_tsp()).
+ * @param options
+ * @return A list of optimal solutions for the changed matrix, the same as solve_tsp() gives.
+ * @throw std::out_of_range If a change is outside the matrix (none of the changes is applied then).
+ */
+tsp_solutions_t resolve_tsp(cost_matrix_t &cm, const std::vector<cost_change_t> &changes,
+                            const tsp_solutions_t &previous, const tsp_options_t &options)
+{
+    // Check all the changes first, so a bad one leaves the matrix as it was
+    for (const cost_change_t &change : changes)
+    {
+        if (change.row >= cm.size() || change.col >= cm[change.row].size())
         {
-            // If the new solution is at least as good as the previous one,
-            // save its lower bound and its path.
-            best_lb = left_branch.get_lower_bound();
-            path_t new_path = left_branch.get_path();
-            // for (auto el : new_path)
-            // {
-            //     std::cout << el << std::endl;
-            // }
-            solutions.push_back({get_optimal_cost(new_path, cm), new_path});
+            throw std::out_of_range("resolve_tsp: change outside the matrix");
         }
     }
+    for (const cost_change_t &change : changes)
+    {
+        cm[change.row][change.col] = change.cost;
+    }
+    if (cm.size() < 2)
+    {
+        return {};
+    }
 
-    return filter_solutions(solutions); // Filter solutions to find only optimal ones.
+    const auto start = std::chrono::steady_clock::now();
+    tsp_solution_t seed{INF, {}};
+    if (wants_warm_start(cm, options))
+    {
+        const path_t *best = nullptr;
+        cost_sum_t best_cost = 0;
+        for (const tsp_solution_t &solution : previous)
+        {
+            if (solution.path.size() != cm.size())
+            {
+                continue;
+            }
+            cost_sum_t cost = 0;
+            for (std::size_t k = 0; k < solution.path.size(); ++k)
+            {
+                const cost_t arc = cm[solution.path[k] - 1][solution.path[(k + 1) % cm.size()] - 1];
+                cost += is_inf(arc) ? FORBIDDEN_COST : arc;
+            }
+            if (best == nullptr || cost < best_cost)
+            {
+                best = &solution.path;
+                best_cost = cost;
+            }
+        }
+        if (best != nullptr)
+        {
+            seed = get_improved_solution(cm, *best);
+        }
+        if (is_inf(seed.lower_bound))
+        {
+            seed = get_heuristic_solution(cm);
+        }
+    }
+    MatrixPool pool(cm.size());
+    return solve_tsp_seeded(cm, options, pool, std::move(seed), start);
 }
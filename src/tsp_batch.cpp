@@ -0,0 +1,113 @@
+#include "TSP.hpp"
+#include "tsp_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Solve many independent instances, spread over several threads. Every
+ * thread takes the next unsolved instance until none is left, and solves it
+ * single-threaded with a matrix pool and a Held-Karp table of its own, kept
+ * for all its instances, so that once they have grown the matrices of the
+ * search and the tables of the dynamic program need no heap allocations.
+ * @param matrices The cost matrices (n_matrices of them).
+ * @param n_matrices
+ * @param results Where the optimal solutions of every matrix are written (n_matrices of them).
+ * @param options The settings of every solve; <tt>n_threads</tt> is the number
+ *        of threads sharing the batch (0 = one per hardware thread). The
+ *        statistics of all solves are added to <tt>stats</tt>; <tt>outcome</tt>
+ *        and <tt>warm_start_report</tt> are not filled in, and <tt>on_tour</tt>
+ *        may be called by several threads at once (for different instances).
+ * @throw Whatever a solve throws (the first one, once all threads have stopped).
+ */
+void solve_tsp_batch(const cost_matrix_t *matrices, std::size_t n_matrices, tsp_solutions_t *results,
+                     const tsp_options_t &options)
+{
+    std::size_t n_threads = options.n_threads;
+    if (n_threads == 0)
+    {
+        n_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    n_threads = std::max<std::size_t>(1, std::min(n_threads, n_matrices));
+
+    std::size_t max_size = 0;
+    for (std::size_t i = 0; i < n_matrices; ++i)
+    {
+        max_size = std::max(max_size, matrices[i].size());
+    }
+
+    std::atomic<std::size_t> next{0};
+    std::vector<search_stats_t> thread_stats(n_threads);
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    auto work = [&](std::size_t id)
+    {
+        tsp_options_t solve_options = options;
+        solve_options.n_threads = 1;
+        solve_options.stats = (options.stats != nullptr) ? &thread_stats[id] : nullptr;
+        solve_options.outcome = nullptr;
+        solve_options.warm_start_report = nullptr;
+        std::vector<cost_t> held_karp_table;
+        solve_options.held_karp_table = &held_karp_table;
+        try
+        {
+            MatrixPool pool(max_size);
+            for (std::size_t i = next++; i < n_matrices; i = next++)
+            {
+                results[i] = solve_tsp(matrices[i], solve_options, pool);
+            }
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+            // Let the other threads run out of instances.
+            next = n_matrices;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (std::size_t id = 1; id < n_threads; ++id)
+    {
+        workers.emplace_back(work, id);
+    }
+    work(0);
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    if (options.stats != nullptr)
+    {
+        for (const search_stats_t &stats : thread_stats)
+        {
+            options.stats->merge(stats);
+        }
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Solve many independent instances, spread over several threads (@see: the overload above).
+ * @param matrices
+ * @param options
+ * @return The optimal solutions of every matrix, in the same order.
+ */
+std::vector<tsp_solutions_t> solve_tsp_batch(const std::vector<cost_matrix_t> &matrices,
+                                             const tsp_options_t &options)
+{
+    std::vector<tsp_solutions_t> results(matrices.size());
+    solve_tsp_batch(matrices.data(), matrices.size(), results.data(), options);
+    return results;
+}
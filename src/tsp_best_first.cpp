@@ -0,0 +1,237 @@
+#include "TSP.hpp"
+#include "tsp_pool.hpp"
+#include "tsp_search.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+/**
+ * Heap order of the open list: the stage with the lowest lower bound comes
+ * first; on a tie the deeper stage (the one closer to a tour), then the one
+ * the depth-first search would visit first.
+ */
+struct worse_node_t {
+    bool operator()(const search_node_t &a, const search_node_t &b) const
+    {
+        if (a.stage.get_lower_bound() != b.stage.get_lower_bound())
+        {
+            return a.stage.get_lower_bound() > b.stage.get_lower_bound();
+        }
+        if (a.stage.get_level() != b.stage.get_level())
+        {
+            return a.stage.get_level() < b.stage.get_level();
+        }
+        return a.branches > b.branches;
+    }
+};
+
+/**
+ * Branch & bound visiting the open stages by their lower bounds
+ * (@see: search_strategy_t). The open list is a binary heap; a stage that
+ * does not fit into it any more is searched depth first right away, so the
+ * memory taken by the open list never exceeds the limit.
+ */
+class BestFirstSearch {
+public:
+    BestFirstSearch(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool, cost_t upper_bound)
+        : cm_(cm), options_(options), pool_(pool), n_levels_(cm.size() - 2), strategy_(options.strategy),
+          max_open_bytes_(options.max_open_bytes), bound_(options.bound), stats_(options.stats), limits_(options),
+          outcome_(options.outcome), tours_(options, upper_bound) {}
+
+    tsp_solutions_t run();
+
+private:
+    static std::size_t node_bytes(const search_node_t &node);
+
+    void push_open(search_node_t &&node);
+    search_node_t pop_open();
+    void search_depth_first(search_node_t &&root);
+    void close(search_node_t &node, step_result_t result);
+    bool limit_reached();
+
+    const cost_matrix_t &cm_;
+    const tsp_options_t &options_;
+    MatrixPool &pool_;
+    const std::size_t n_levels_;
+    const search_strategy_t strategy_;
+    const std::size_t max_open_bytes_;
+    const IBoundingEngine *bound_;
+    StatsRecorder stats_;
+    const SearchLimits limits_;
+    search_outcome_t *outcome_;
+    std::size_t n_nodes_ = 0;
+    bool stopped_ = false;
+
+    std::vector<search_node_t> open_;
+    std::size_t open_bytes_ = 0;
+
+    TourCollector tours_;
+};
+
+tsp_solutions_t BestFirstSearch::run()
+{
+    push_open({get_root_stage(cm_, options_, pool_), {}});
+
+    while (!open_.empty())
+    {
+        if (limit_reached())
+        {
+            // The top of the heap has the lowest lower bound of the open stages.
+            stop_search(outcome_, open_.front().stage.get_lower_bound());
+            break;
+        }
+        search_node_t node = pop_open();
+        // No open stage has a lower bound below this one.
+        if (exceeds_bound(node.stage.get_lower_bound(), tours_.bound()))
+        {
+            break;
+        }
+
+        auto push_right = [this, &node](StageState &&right_branch)
+        {
+            std::vector<bool> right_branches(node.branches);
+            right_branches.push_back(true);
+            push_open({std::move(right_branch), std::move(right_branches)});
+        };
+
+        step_result_t result = branch_step(node.stage, n_levels_, tours_.bound(), push_right, bound_, stats_);
+        if (strategy_ == search_strategy_t::BestFirst && result == step_result_t::Branched)
+        {
+            ++n_nodes_;
+            node.branches.push_back(false);
+            push_open(std::move(node));
+            continue;
+        }
+        // Hybrid: dive along the left branches down to a leaf.
+        while (result == step_result_t::Branched)
+        {
+            ++n_nodes_;
+            node.branches.push_back(false);
+            result = branch_step(node.stage, n_levels_, tours_.bound(), push_right, bound_, stats_);
+        }
+        close(node, result);
+    }
+
+    return tours_.take();
+}
+
+/**
+ * @return The number of bytes the node takes in the open list.
+ */
+std::size_t BestFirstSearch::node_bytes(const search_node_t &node)
+{
+    return sizeof(search_node_t) - sizeof(StageState) + node.stage.memory_usage() + node.branches.capacity() / 8;
+}
+
+void BestFirstSearch::push_open(search_node_t &&node)
+{
+    const std::size_t bytes = node_bytes(node);
+    if (max_open_bytes_ != 0 && open_bytes_ + bytes > max_open_bytes_)
+    {
+        search_depth_first(std::move(node));
+        return;
+    }
+    open_bytes_ += bytes;
+    open_.push_back(std::move(node));
+    std::push_heap(open_.begin(), open_.end(), worse_node_t());
+    stats_.waiting(open_.size());
+}
+
+search_node_t BestFirstSearch::pop_open()
+{
+    std::pop_heap(open_.begin(), open_.end(), worse_node_t());
+    search_node_t node = std::move(open_.back());
+    open_.pop_back();
+    open_bytes_ -= node_bytes(node);
+    return node;
+}
+
+/**
+ * Search the whole subtree of the node depth first, like solve_tsp() does
+ * (unless a limit is reached).
+ * @param root
+ */
+void BestFirstSearch::search_depth_first(search_node_t &&root)
+{
+    std::vector<search_node_t> tree_lifo;
+    tree_lifo.push_back(std::move(root));
+
+    while (!tree_lifo.empty())
+    {
+        if (limit_reached())
+        {
+            cost_t open_lb = INF;
+            for (const search_node_t &open : tree_lifo)
+            {
+                open_lb = std::min(open_lb, open.stage.get_lower_bound());
+            }
+            stop_search(outcome_, open_lb);
+            break;
+        }
+        search_node_t node = std::move(tree_lifo.back());
+        tree_lifo.pop_back();
+
+        auto push_right = [this, &tree_lifo, &node](StageState &&right_branch)
+        {
+            std::vector<bool> right_branches(node.branches);
+            right_branches.push_back(true);
+            tree_lifo.push_back({std::move(right_branch), std::move(right_branches)});
+            stats_.waiting(open_.size() + tree_lifo.size());
+        };
+
+        step_result_t result;
+        while ((result = branch_step(node.stage, n_levels_, tours_.bound(), push_right, bound_, stats_)) ==
+               step_result_t::Branched)
+        {
+            ++n_nodes_;
+            node.branches.push_back(false);
+        }
+        close(node, result);
+    }
+}
+
+/**
+ * Check the limits before taking an open stage; once one is reached, it stays reached.
+ * @return Whether the search has to stop.
+ */
+bool BestFirstSearch::limit_reached()
+{
+    stopped_ = stopped_ || limits_.reached(n_nodes_);
+    return stopped_;
+}
+
+void BestFirstSearch::close(search_node_t &node, step_result_t result)
+{
+    tsp_solution_t solution;
+    if (result == step_result_t::Leaf && close_leaf(node.stage, cm_, tours_.bound(), solution, stats_))
+    {
+        const cost_t cost = solution.lower_bound;
+        if (tours_.add(std::move(solution), std::move(node.branches)))
+        {
+            stats_.incumbent(cost);
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * Solve the TSP visiting the open stages by their lower bounds.
+ * @param cm The cost matrix.
+ * @param options The strategy (BestFirst or Hybrid), the memory limit of the open list, the limits of the
+ *                search, the statistics, the outcome and the tours to keep.
+ * @param pool The buffers for the matrices of the search tree.
+ * @param upper_bound The cost of a known tour (INF if none).
+ * @return A list of optimal solutions, in the same order as the depth-first search gives them.
+ */
+tsp_solutions_t solve_tsp_best_first(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool,
+                                     cost_t upper_bound)
+{
+    if (cm.size() < 2)
+    {
+        return {};
+    }
+    return BestFirstSearch(cm, options, pool, upper_bound).run();
+}
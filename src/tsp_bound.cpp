@@ -0,0 +1,392 @@
+#include "tsp_bound.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+constexpr double infinity = std::numeric_limits<double>::infinity();
+constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+/**
+ * Find the cheapest 1-tree: a spanning tree of cities 1..m-1 (Prim's
+ * algorithm on the dense graph) plus the two cheapest edges of city 0.
+ * @param weights The m x m edge costs (infinity = forbidden).
+ * @param m The number of cities.
+ * @param pi The penalties of the cities, added to the cost of their edges.
+ * @param degree Set to the degree of every city in the 1-tree.
+ * @return The cost of the 1-tree minus twice the sum of the penalties
+ *         (infinity if every 1-tree has a forbidden edge).
+ */
+double get_one_tree(const std::vector<double> &weights, std::size_t m, const std::vector<double> &pi,
+                    std::vector<int> &degree)
+{
+    // Reused between calls, so that computing the bound does not allocate.
+    static thread_local std::vector<double> dist;
+    static thread_local std::vector<std::size_t> parent;
+    static thread_local std::vector<unsigned char> in_tree;
+    dist.assign(m, infinity);
+    parent.assign(m, 0);
+    in_tree.assign(m, 0);
+    degree.assign(m, 0);
+
+    double cost = 0;
+    dist[1] = 0;
+    for (std::size_t step = 1; step < m; ++step)
+    {
+        std::size_t v = npos;
+        for (std::size_t u = 1; u < m; ++u)
+        {
+            if (!in_tree[u] && (v == npos || dist[u] < dist[v]))
+            {
+                v = u;
+            }
+        }
+        if (dist[v] == infinity)
+        {
+            return infinity;
+        }
+        in_tree[v] = 1;
+        if (step > 1)
+        {
+            cost += dist[v];
+            ++degree[v];
+            ++degree[parent[v]];
+        }
+        const double *row = weights.data() + v * m;
+        for (std::size_t u = 1; u < m; ++u)
+        {
+            const double w = row[u] + pi[v] + pi[u];
+            if (!in_tree[u] && w < dist[u])
+            {
+                dist[u] = w;
+                parent[u] = v;
+            }
+        }
+    }
+
+    std::size_t first = npos;
+    std::size_t second = npos;
+    for (std::size_t u = 1; u < m; ++u)
+    {
+        const double w = weights[u] + pi[u];
+        if (first == npos || w < weights[first] + pi[first])
+        {
+            second = first;
+            first = u;
+        }
+        else if (second == npos || w < weights[second] + pi[second])
+        {
+            second = u;
+        }
+    }
+    if (weights[second] == infinity)
+    {
+        return infinity;
+    }
+    cost += weights[first] + weights[second] + 2 * pi[0] + pi[first] + pi[second];
+    degree[0] = 2;
+    ++degree[first];
+    ++degree[second];
+
+    double penalties = 0;
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        penalties += pi[k];
+    }
+    return cost - 2 * penalties;
+}
+
+} // namespace
+
+/**
+ * Compute the Held-Karp bound of the stage with subgradient optimization,
+ * starting from the penalties kept in the stage and storing the best ones
+ * found back into it.
+ * @param stage A stage with a reduced matrix.
+ * @param best_lb The cost of the best tour found so far (the target of the steps).
+ * @return The reduction sum of the stage plus the bound of its reduced matrix
+ *         (INF if the stage cannot be completed into a tour).
+ */
+cost_t OneTreeBound::get_lower_bound(StageState &stage, cost_t best_lb) const
+{
+    const cost_t lb = stage.get_reduction_sum();
+    const std::vector<std::size_t> &rows = stage.get_rows();
+    const std::vector<std::size_t> &cols = stage.get_cols();
+    const std::size_t m = rows.size();
+    if (m < 3)
+    {
+        return lb;
+    }
+    const std::size_t n = m + stage.get_unsorted_path().size();
+    const bool full = stage.get_layout() == StageState::Layout::Full;
+
+    // Contract every path fragment into one city, which is left through the
+    // row of its last city and entered through the column of its first one.
+    std::vector<std::size_t> pred(n, npos);
+    for (const auto &v : stage.get_unsorted_path())
+    {
+        pred[v.col] = v.row;
+    }
+    std::vector<std::size_t> col_pos(n, npos);
+    for (std::size_t j = 0; j < cols.size(); ++j)
+    {
+        col_pos[cols[j]] = j;
+    }
+    std::vector<std::size_t> row_idx(m);
+    std::vector<std::size_t> col_idx(m);
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        std::size_t head = rows[k];
+        while (pred[head] != npos)
+        {
+            head = pred[head];
+        }
+        row_idx[k] = full ? rows[k] : k;
+        col_idx[k] = full ? head : col_pos[head];
+    }
+
+    const CostMatrix &matrix = stage.get_matrix();
+    std::vector<double> weights(m * m, infinity);
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        for (std::size_t l = k + 1; l < m; ++l)
+        {
+            const cost_t w = std::min(matrix[row_idx[k]][col_idx[l]], matrix[row_idx[l]][col_idx[k]]);
+            if (!is_inf(w))
+            {
+                weights[k * m + l] = static_cast<double>(w);
+                weights[l * m + k] = static_cast<double>(w);
+            }
+        }
+    }
+
+    std::vector<double> &penalties = stage.get_bound_state().penalties;
+    const bool warm = !penalties.empty();
+    if (!warm)
+    {
+        penalties.assign(n, 0.0);
+    }
+    std::vector<double> pi(m);
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        pi[k] = penalties[rows[k]];
+    }
+
+    // What is left of the best cost after the reduction; the bound prunes
+    // the stage once it exceeds it.
+    const double budget = is_inf(best_lb) ? infinity : static_cast<double>(best_lb) - static_cast<double>(lb);
+    const std::size_t iterations = warm ? iterations_ : root_iterations_;
+    double step_scale = warm ? 1.0 : 2.0;
+    std::size_t since_improved = 0;
+    double best_bound = -infinity;
+    std::vector<double> best_pi(pi);
+    std::vector<int> degree;
+    for (std::size_t it = 0; it < iterations; ++it)
+    {
+        const double bound = get_one_tree(weights, m, pi, degree);
+        if (bound == infinity)
+        {
+            return INF;
+        }
+        if (bound > best_bound)
+        {
+            best_bound = bound;
+            best_pi = pi;
+            since_improved = 0;
+        }
+        else if (++since_improved == 5)
+        {
+            step_scale /= 2;
+            since_improved = 0;
+        }
+        if (best_bound > budget)
+        {
+            break;
+        }
+
+        double norm = 0;
+        for (std::size_t k = 0; k < m; ++k)
+        {
+            norm += (degree[k] - 2) * (degree[k] - 2);
+        }
+        // Every city has degree 2: the 1-tree is a tour, and no penalties do better.
+        if (norm == 0)
+        {
+            break;
+        }
+        const double target = (budget == infinity) ? bound + 0.1 * std::abs(bound) + 1 : budget + 1;
+        const double step = step_scale * (target - bound) / norm;
+        for (std::size_t k = 0; k < m; ++k)
+        {
+            pi[k] += step * (degree[k] - 2);
+        }
+    }
+
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        penalties[rows[k]] = best_pi[k];
+    }
+    if (best_bound == -infinity)
+    {
+        return lb;
+    }
+    // The margin keeps rounding errors from cutting off a tour; integer costs
+    // make tours cost a whole number, so the bound rounds up to one.
+    const double margin = 1e-6 * std::max(1.0, std::abs(best_bound));
+    const double bound = std::is_integral<cost_t>::value ? std::ceil(best_bound - 1e-6) : best_bound - margin;
+    const double total = bound + static_cast<double>(lb);
+    return total >= static_cast<double>(INF) ? INF : std::max(lb, static_cast<cost_t>(total));
+}
+
+/**
+ * Compute the cheapest assignment of the reduced matrix of the stage, keeping
+ * the rows still assigned to a zero cell since the parent, and fold its dual
+ * potentials into the reduction of the stage.
+ * @param stage A stage with a reduced matrix.
+ * @return The reduction sum of the stage including the potentials
+ *         (INF if no assignment avoids the forbidden cells).
+ */
+cost_t AssignmentBound::get_lower_bound(StageState &stage, cost_t) const
+{
+    const std::vector<std::size_t> &rows = stage.get_rows();
+    const std::vector<std::size_t> &cols = stage.get_cols();
+    const std::size_t m = rows.size();
+    if (m == 0)
+    {
+        return stage.get_reduction_sum();
+    }
+    const std::size_t n = m + stage.get_unsorted_path().size();
+    const bool full = stage.get_layout() == StageState::Layout::Full;
+    const CostMatrix &matrix = stage.get_matrix();
+    auto cell = [&](std::size_t i, std::size_t j)
+    {
+        return matrix[full ? rows[i] : i][full ? cols[j] : j];
+    };
+
+    std::vector<std::size_t> col_pos(n, npos);
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        col_pos[cols[j]] = j;
+    }
+
+    // The row assigned to every column: what is left of the parent's assignment.
+    std::vector<std::size_t> &assignment = stage.get_bound_state().assignment;
+    assignment.resize(n, npos);
+    std::vector<std::size_t> owner(m, npos);
+    for (std::size_t i = 0; i < m; ++i)
+    {
+        const std::size_t col = assignment[rows[i]];
+        const std::size_t j = (col == npos) ? npos : col_pos[col];
+        if (j != npos && owner[j] == npos && cell(i, j) == 0)
+        {
+            owner[j] = i;
+        }
+    }
+    std::vector<unsigned char> assigned(m, 0);
+    for (std::size_t j = 0; j < m; ++j)
+    {
+        if (owner[j] != npos)
+        {
+            assigned[owner[j]] = 1;
+        }
+    }
+
+    // The reduced matrix has no negative cells, so zero potentials are
+    // feasible, and the zero cells kept above satisfy complementary slackness.
+    constexpr cost_sum_t unreachable = std::numeric_limits<cost_sum_t>::max();
+    std::vector<cost_sum_t> u(m, 0);
+    std::vector<cost_sum_t> v(m, 0);
+    std::vector<cost_sum_t> min_slack(m);
+    std::vector<std::size_t> way(m);
+    std::vector<unsigned char> visited(m);
+    for (std::size_t start = 0; start < m; ++start)
+    {
+        if (assigned[start])
+        {
+            continue;
+        }
+        // Dijkstra over the reduced costs from the unassigned row to a free
+        // column; way[j] is the column through which j was reached (npos = start).
+        std::fill(min_slack.begin(), min_slack.end(), unreachable);
+        std::fill(visited.begin(), visited.end(), 0);
+        std::size_t row = start;
+        std::size_t j0 = npos;
+        std::vector<std::size_t> tree({start});
+        while (true)
+        {
+            cost_sum_t delta = unreachable;
+            std::size_t j1 = npos;
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                if (visited[j])
+                {
+                    continue;
+                }
+                const cost_t c = cell(row, j);
+                if (!is_inf(c))
+                {
+                    const cost_sum_t slack = c - u[row] - v[j];
+                    if (slack < min_slack[j])
+                    {
+                        min_slack[j] = slack;
+                        way[j] = j0;
+                    }
+                }
+                if (min_slack[j] < delta)
+                {
+                    delta = min_slack[j];
+                    j1 = j;
+                }
+            }
+            if (j1 == npos)
+            {
+                return INF;
+            }
+            for (std::size_t i : tree)
+            {
+                u[i] += delta;
+            }
+            for (std::size_t j = 0; j < m; ++j)
+            {
+                if (visited[j])
+                {
+                    v[j] -= delta;
+                }
+                else if (min_slack[j] != unreachable)
+                {
+                    min_slack[j] -= delta;
+                }
+            }
+            visited[j1] = 1;
+            j0 = j1;
+            if (owner[j1] == npos)
+            {
+                break;
+            }
+            row = owner[j1];
+            tree.push_back(row);
+        }
+        // Flip the path: every column takes the row of the column before it.
+        while (j0 != npos)
+        {
+            const std::size_t prev = way[j0];
+            owner[j0] = (prev == npos) ? start : owner[prev];
+            j0 = prev;
+        }
+    }
+
+    std::vector<cost_t> row_values(matrix.size(), 0);
+    std::vector<cost_t> col_values(matrix.size(), 0);
+    for (std::size_t k = 0; k < m; ++k)
+    {
+        row_values[full ? rows[k] : k] = static_cast<cost_t>(u[k]);
+        col_values[full ? cols[k] : k] = static_cast<cost_t>(v[k]);
+        assignment[rows[owner[k]]] = cols[k];
+    }
+    stage.apply_potentials(row_values, col_values);
+    return stage.get_reduction_sum();
+}
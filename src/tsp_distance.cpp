@@ -0,0 +1,88 @@
+#include "tsp_distance.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @param a
+ * @param b
+ * @param rounding
+ * @return The Euclidean distance between the points, rounded to an integer
+ *   (INF if it does not fit into <tt>cost_t</tt>).
+ */
+cost_t get_distance(const point_t &a, const point_t &b, rounding_t rounding)
+{
+    const double dx = a.x - b.x;
+    const double dy = a.y - b.y;
+    const double distance = std::sqrt(dx * dx + dy * dy);
+    const double rounded = (rounding == rounding_t::Nearest) ? std::floor(distance + 0.5) : std::ceil(distance);
+    return (rounded >= static_cast<double>(INF)) ? INF : static_cast<cost_t>(rounded);
+}
+
+PointDistances::PointDistances(std::vector<point_t> points, rounding_t rounding, std::size_t cached_rows)
+    : points_(std::move(points)), rounding_(rounding), cached_rows_(std::max<std::size_t>(1, cached_rows))
+{
+}
+
+/**
+ * Get the costs from a city to all cities, from the cache or computed (and
+ * cached, in place of the least recently used row).
+ * @param from
+ * @return The row; valid until the next call to row().
+ */
+const cost_t *PointDistances::row(std::size_t from) const
+{
+    ++clock_;
+    auto found = std::find_if(cache_.begin(), cache_.end(),
+                              [from](const cached_row_t &cached) { return cached.city == from; });
+    if (found == cache_.end())
+    {
+        if (cache_.size() < cached_rows_)
+        {
+            cache_.push_back({from, 0, std::vector<cost_t>(points_.size())});
+            found = cache_.end() - 1;
+        }
+        else
+        {
+            found = std::min_element(cache_.begin(), cache_.end(),
+                                     [](const cached_row_t &a, const cached_row_t &b)
+                                     {
+                                         return a.last_used < b.last_used;
+                                     });
+            found->city = from;
+        }
+        for (std::size_t to = 0; to < points_.size(); ++to)
+        {
+            found->costs[to] = (*this)(from, to);
+        }
+    }
+    found->last_used = clock_;
+    return found->costs.data();
+}
+
+/**
+ * @return The full cost matrix (for the solvers which need one).
+ */
+cost_matrix_t PointDistances::get_matrix() const
+{
+    const std::size_t n = points_.size();
+    cost_matrix_t matrix(n, std::vector<cost_t>(n));
+    for (std::size_t from = 0; from < n; ++from)
+    {
+        for (std::size_t to = 0; to < n; ++to)
+        {
+            matrix[from][to] = (*this)(from, to);
+        }
+    }
+    return matrix;
+}
+
+/**
+ * @return The number of bytes taken by the points and the cached rows.
+ */
+std::size_t PointDistances::memory_usage() const
+{
+    return sizeof(PointDistances) + points_.capacity() * sizeof(point_t)
+           + cache_.capacity() * sizeof(cached_row_t) + cache_.size() * points_.size() * sizeof(cost_t);
+}
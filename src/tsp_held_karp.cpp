@@ -0,0 +1,318 @@
+#include "TSP.hpp"
+#include "tsp_kernels.hpp"
+#include "tsp_search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using subset_t = std::uint32_t;
+
+/// The subsets of the cities 2..N ordered by their size (@see: get_subset_order()).
+struct subset_order_t {
+    std::vector<subset_t> subsets;
+    // Size k takes subsets[layers[k]]..subsets[layers[k+1]].
+    std::vector<std::size_t> layers;
+};
+
+/**
+ * Order the subsets of some cities by their size. Every number of cities is
+ * ordered once and kept for all later solves (the orders take less memory
+ * than a single table of the dynamic program).
+ * @param n_cities The number of cities in the subsets (N - 1).
+ * @return The order; valid until the program ends.
+ * @throw std::length_error If there are too many cities to number the subsets.
+ */
+const subset_order_t &get_subset_order(std::size_t n_cities)
+{
+    static std::mutex mutex;
+    static std::vector<std::unique_ptr<const subset_order_t>> orders;
+
+    if (n_cities >= std::numeric_limits<subset_t>::digits)
+    {
+        throw std::length_error("Held-Karp: too many cities");
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (orders.size() <= n_cities)
+    {
+        orders.resize(n_cities + 1);
+    }
+    if (!orders[n_cities])
+    {
+        // Counting sort of the subsets by their size.
+        const std::size_t n_subsets = std::size_t(1) << n_cities;
+        auto order = std::make_unique<subset_order_t>();
+        order->layers.assign(n_cities + 2, 0);
+        for (std::size_t subset = 0; subset < n_subsets; ++subset)
+        {
+            ++order->layers[static_cast<std::size_t>(__builtin_popcount(static_cast<subset_t>(subset))) + 1];
+        }
+        for (std::size_t k = 1; k < order->layers.size(); ++k)
+        {
+            order->layers[k] += order->layers[k - 1];
+        }
+        order->subsets.resize(n_subsets);
+        std::vector<std::size_t> next(order->layers.begin(), order->layers.end() - 1);
+        for (std::size_t subset = 0; subset < n_subsets; ++subset)
+        {
+            order->subsets[next[static_cast<std::size_t>(__builtin_popcount(static_cast<subset_t>(subset)))]++] =
+                static_cast<subset_t>(subset);
+        }
+        orders[n_cities] = std::move(order);
+    }
+    return *orders[n_cities];
+}
+
+/**
+ * The Held-Karp dynamic program over the subsets of the cities 2..N (bit k-1
+ * standing for city k, 0-based).
+ *
+ * The table has a row of N costs for every subset S: the cost of the
+ * cheapest path which starts in the first city, visits the cities of S (in
+ * any order) and then goes to city j, for every j not in S. A row is the
+ * minimum, over the cities k of S, of the row of S - {k} at k plus the row
+ * of k in the cost matrix, so it is built with a single vectorized min-plus
+ * step over whole rows. The row of the full set at the first city is the optimal
+ * cost. The subsets of the same size only depend on smaller ones, so they
+ * are solved in layers, spread over the threads.
+ */
+class HeldKarp {
+public:
+    HeldKarp(const cost_matrix_t &cm, const tsp_options_t &options);
+
+    tsp_solutions_t run();
+
+private:
+    cost_t *row(subset_t subset) { return table_ + static_cast<std::size_t>(subset) * n_; }
+
+    void solve_subset(subset_t subset);
+    void solve_layer(std::size_t end);
+    void collect(subset_t subset, std::size_t to, path_t &tail);
+
+    const cost_matrix_t &cm_;
+    const tsp_options_t &options_;
+    const std::size_t n_;
+    const cost_kernels_t &kernels_;
+    const subset_order_t &order_;
+    // The table of the caller (options.held_karp_table) or of this solve.
+    std::vector<cost_t> own_table_;
+    cost_t *table_ = nullptr;
+
+    const SearchLimits limits_;
+    // The next subset of the current layer to be taken by a thread.
+    std::atomic<std::size_t> next_{0};
+    std::atomic<std::size_t> n_solved_{0};
+    std::atomic<bool> stopped_{false};
+    TourCollector tours_;
+    cost_t optimum_ = INF;
+    // Whether only the tours whose second city is lower than their last one are kept.
+    const bool skip_reversed_;
+
+    static constexpr std::size_t chunk_size = 64;
+};
+
+HeldKarp::HeldKarp(const cost_matrix_t &cm, const tsp_options_t &options)
+    : cm_(cm), options_(options), n_(cm.size()), kernels_(get_cost_kernels()), order_(get_subset_order(n_ - 1)),
+      limits_(options), tours_(options, INF), skip_reversed_(options.skip_reversed_tours && is_symmetric(cm))
+{
+    std::vector<cost_t> &table = (options.held_karp_table != nullptr) ? *options.held_karp_table : own_table_;
+    // Every row is written before it is read, so the table is neither cleared nor shrunk.
+    const std::size_t n_cells = order_.subsets.size() * n_;
+    if (table.size() < n_cells)
+    {
+        table.resize(n_cells);
+    }
+    table_ = table.data();
+}
+
+/**
+ * Solve the subsets layer by layer, then collect the optimal tours.
+ * @return The optimal tours, ordered by their last city, then by the one
+ *         before it and so on (nothing if a limit stopped the search).
+ */
+tsp_solutions_t HeldKarp::run()
+{
+    StatsRecorder stats(options_.stats);
+    std::size_t n_threads = options_.n_threads;
+    if (n_threads == 0)
+    {
+        n_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    // The empty set: going straight from the first city.
+    std::copy(cm_[0].cbegin(), cm_[0].cend(), row(0));
+    for (std::size_t layer = 1; layer + 1 < order_.layers.size() && !stopped_; ++layer)
+    {
+        const std::size_t end = order_.layers[layer + 1];
+        next_ = order_.layers[layer];
+        // Small layers are not worth starting threads for.
+        std::vector<std::thread> workers;
+        for (std::size_t k = 1; k < std::min(n_threads, (end - order_.layers[layer]) / chunk_size); ++k)
+        {
+            workers.emplace_back([this, end] { solve_layer(end); });
+        }
+        solve_layer(end);
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+    stats.expanded(n_solved_);
+
+    if (stopped_)
+    {
+        // Only the reduction of the matrix is known to bound the tours.
+        CostMatrix root(cm_);
+        const cost_t reduced = root.reduce_cols();
+        stop_search(options_.outcome, add_costs(reduced, root.reduce_rows()));
+        return {};
+    }
+
+    const subset_t all = static_cast<subset_t>((std::size_t(1) << (n_ - 1)) - 1);
+    optimum_ = row(all)[0];
+    if (!is_inf(optimum_))
+    {
+        stats.incumbent(optimum_);
+        path_t tail;
+        collect(all, 0, tail);
+    }
+    return tours_.take();
+}
+
+/**
+ * Solve the subsets of the current layer not taken by another thread yet, a
+ * chunk at a time, until the layer ends or a limit is reached.
+ * @param end The end of the layer in the order of the subsets.
+ */
+void HeldKarp::solve_layer(std::size_t end)
+{
+    while (!stopped_)
+    {
+        const std::size_t first = next_.fetch_add(chunk_size);
+        if (first >= end)
+        {
+            return;
+        }
+        if (limits_.reached(n_solved_))
+        {
+            stopped_ = true;
+            return;
+        }
+        const std::size_t last = std::min(first + chunk_size, end);
+        for (std::size_t k = first; k < last; ++k)
+        {
+            solve_subset(order_.subsets[k]);
+        }
+        n_solved_ += last - first;
+    }
+}
+
+/**
+ * Fill the row of a subset from the rows of the subsets one city smaller.
+ * @param subset
+ */
+void HeldKarp::solve_subset(subset_t subset)
+{
+    // The paths ending in every city k of the subset, and the rows of those cities.
+    cost_t values[std::numeric_limits<subset_t>::digits];
+    const cost_t *others[std::numeric_limits<subset_t>::digits];
+    std::size_t n_values = 0;
+    for (subset_t rest = subset; rest != 0; rest &= rest - 1)
+    {
+        const std::size_t k = static_cast<std::size_t>(__builtin_ctz(rest)) + 1;
+        const cost_t value = row(subset & ~(subset_t(1) << (k - 1)))[k];
+        if (!is_inf(value))
+        {
+            values[n_values] = value;
+            others[n_values] = cm_[k].data();
+            ++n_values;
+        }
+    }
+    kernels_.min_plus(row(subset), n_, values, others, n_values);
+}
+
+/**
+ * Follow the optimal predecessors back from a city, adding a tour for every
+ * way of reaching the first city.
+ * @param subset The cities still to visit before <tt>to</tt>.
+ * @param to The city (0-based) reached after them.
+ * @param tail The cities (1-based) after <tt>to</tt>, in reverse order.
+ */
+void HeldKarp::collect(subset_t subset, std::size_t to, path_t &tail)
+{
+    // Enough optimal tours kept.
+    if (tours_.bound() < optimum_)
+    {
+        return;
+    }
+    if (subset == 0)
+    {
+        path_t path({1});
+        path.insert(path.end(), tail.rbegin(), tail.rend());
+        if (skip_reversed_ && path.size() > 2 && path[1] > path.back())
+        {
+            return;
+        }
+        const cost_t cost = get_optimal_cost(path, cm_);
+        tours_.add({cost, std::move(path)});
+        return;
+    }
+    const cost_t target = row(subset)[to];
+    for (subset_t rest = subset; rest != 0; rest &= rest - 1)
+    {
+        const std::size_t k = static_cast<std::size_t>(__builtin_ctz(rest)) + 1;
+        const subset_t before = subset & ~(subset_t(1) << (k - 1));
+        const cost_t value = row(before)[k];
+        if (!is_inf(value) && add_costs(value, cm_[k][to]) == target)
+        {
+            tail.push_back(k + 1);
+            collect(before, k, tail);
+            tail.pop_back();
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @param n The number of cities.
+ * @return The memory (in bytes) the Held-Karp engine takes for n cities
+ *         (the largest std::size_t if it cannot solve them).
+ */
+std::size_t get_held_karp_bytes(std::size_t n)
+{
+    if (n < 2)
+    {
+        return 0;
+    }
+    if (n - 1 >= std::numeric_limits<subset_t>::digits)
+    {
+        return std::numeric_limits<std::size_t>::max();
+    }
+    return (std::size_t(1) << (n - 1)) * (n * sizeof(cost_t) + sizeof(subset_t));
+}
+
+/**
+ * Solve the TSP with the Held-Karp dynamic program (@see: tsp_engine_t::HeldKarp).
+ * @param cm The cost matrix.
+ * @param options The threads (<tt>n_threads</tt>), the limits, the statistics, the outcome, the tours to keep
+ *        and the table to reuse (<tt>held_karp_table</tt>).
+ * @return A list of optimal solutions (nothing if a limit stopped the search).
+ * @throw std::length_error If there are too many cities to number the subsets.
+ */
+tsp_solutions_t solve_tsp_held_karp(const cost_matrix_t &cm, const tsp_options_t &options)
+{
+    if (cm.size() < 2)
+    {
+        return {};
+    }
+    return HeldKarp(cm, options).run();
+}
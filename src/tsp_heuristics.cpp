@@ -0,0 +1,369 @@
+#include "tsp_heuristics.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+/**
+ * The cost of going from one city to another (1-based, as in path_t). INF
+ * counts as a very large, but finite, cost (FORBIDDEN_COST), so that the
+ * local search can also get rid of forbidden transitions.
+ * @param cm
+ * @param from
+ * @param to
+ * @return The cost.
+ */
+static cost_sum_t arc_cost(const cost_matrix_t &cm, std::size_t from, std::size_t to)
+{
+    const cost_t cost = cm[from - 1][to - 1];
+    return is_inf(cost) ? FORBIDDEN_COST : cost;
+}
+
+/**
+ * The cost of the closed tour, counting INF as above.
+ * @param cm
+ * @param path
+ * @return The cost.
+ */
+static cost_sum_t path_cost(const cost_matrix_t &cm, const path_t &path)
+{
+    cost_sum_t cost = 0;
+    for (std::size_t k = 0; k < path.size(); ++k)
+    {
+        cost += arc_cost(cm, path[k], path[(k + 1) % path.size()]);
+    }
+    return cost;
+}
+
+/**
+ * Rotate a tour so that it starts at city 1, like the tours of the solver.
+ * @param next The successor of every city (0-based).
+ * @return The path (1-based).
+ */
+static path_t path_from_successors(const std::vector<std::size_t> &next)
+{
+    path_t path({1});
+    for (std::size_t city = next[0]; city != 0; city = next[city])
+    {
+        path.push_back(city + 1);
+    }
+    return path;
+}
+
+/**
+ * Build a tour by always going to the cheapest city not visited yet.
+ * @param cm The cost matrix.
+ * @param start The first city (0-based).
+ * @return The tour (starting at city 1).
+ */
+path_t get_nearest_neighbour_path(const cost_matrix_t &cm, std::size_t start)
+{
+    const std::size_t n = cm.size();
+    if (n == 0)
+    {
+        return {};
+    }
+    std::vector<bool> visited(n, false);
+    std::vector<std::size_t> next(n);
+    std::size_t city = start;
+    visited[city] = true;
+    for (std::size_t step = 1; step < n; ++step)
+    {
+        std::size_t best = n;
+        for (std::size_t to = 0; to < n; ++to)
+        {
+            if (!visited[to] && (best == n || cm[city][to] < cm[city][best]))
+            {
+                best = to;
+            }
+        }
+        next[city] = best;
+        visited[best] = true;
+        city = best;
+    }
+    next[city] = start;
+    return path_from_successors(next);
+}
+
+/**
+ * Build a tour by taking the cheapest transitions first, skipping those which
+ * would leave a city twice, enter a city twice or close a subtour. Fragments
+ * left unconnected (if too many transitions are forbidden) are joined in any order.
+ * @param cm The cost matrix.
+ * @return The tour (starting at city 1).
+ */
+path_t get_greedy_edge_path(const cost_matrix_t &cm)
+{
+    const std::size_t n = cm.size();
+    if (n == 0)
+    {
+        return {};
+    }
+    constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    std::vector<std::tuple<cost_t, std::size_t, std::size_t>> arcs;
+    for (std::size_t from = 0; from < n; ++from)
+    {
+        for (std::size_t to = 0; to < n; ++to)
+        {
+            if (from != to && !is_inf(cm[from][to]))
+            {
+                arcs.emplace_back(cm[from][to], from, to);
+            }
+        }
+    }
+    std::sort(arcs.begin(), arcs.end());
+
+    // The first city of the fragment ending at a city, and the last city of
+    // the fragment starting at a city (every city starts as its own fragment).
+    std::vector<std::size_t> next(n, none);
+    std::vector<std::size_t> prev(n, none);
+    std::vector<std::size_t> first(n);
+    std::vector<std::size_t> last(n);
+    for (std::size_t city = 0; city < n; ++city)
+    {
+        first[city] = city;
+        last[city] = city;
+    }
+    auto link = [&](std::size_t from, std::size_t to)
+    {
+        const std::size_t head = first[from];
+        const std::size_t tail = last[to];
+        next[from] = to;
+        prev[to] = from;
+        last[head] = tail;
+        first[tail] = head;
+    };
+
+    std::size_t n_arcs = 0;
+    for (const auto &arc : arcs)
+    {
+        const std::size_t from = std::get<1>(arc);
+        const std::size_t to = std::get<2>(arc);
+        if (next[from] != none || prev[to] != none || (first[from] == to && n_arcs + 1 < n))
+        {
+            continue;
+        }
+        link(from, to);
+        if (++n_arcs == n)
+        {
+            break;
+        }
+    }
+
+    if (n_arcs < n)
+    {
+        std::vector<std::size_t> heads;
+        for (std::size_t city = 0; city < n; ++city)
+        {
+            if (prev[city] == none)
+            {
+                heads.push_back(city);
+            }
+        }
+        for (std::size_t k = 0; k < heads.size(); ++k)
+        {
+            next[last[heads[k]]] = heads[(k + 1) % heads.size()];
+        }
+    }
+    return path_from_successors(next);
+}
+
+/**
+ * The least decrease of the cost worth a move on a tour: any for integer
+ * costs; for floating-point costs, more than the rounding errors of the sums
+ * (moves gaining nothing could otherwise undo each other forever).
+ * @param tour_cost
+ * @return The gain.
+ */
+static cost_sum_t get_min_gain(cost_sum_t tour_cost)
+{
+    return 64 * std::numeric_limits<cost_sum_t>::epsilon() * std::max<cost_sum_t>(1, tour_cost);
+}
+
+/**
+ * Apply the best improving 2-opt move: reverse the segment path[i+1..j].
+ * The cost of the segment in both directions is taken from prefix sums, so
+ * every move (also on an asymmetric matrix) is evaluated in O(1).
+ * @param cm The cost matrix.
+ * @param path
+ * @return Whether the path was improved.
+ */
+bool improve_two_opt(const cost_matrix_t &cm, path_t &path)
+{
+    const std::size_t n = path.size();
+    if (n < 4)
+    {
+        return false;
+    }
+    // forward[k] (backward[k]) is the cost of path[0..k] walked forwards (backwards).
+    std::vector<cost_sum_t> forward(n, 0);
+    std::vector<cost_sum_t> backward(n, 0);
+    for (std::size_t k = 1; k < n; ++k)
+    {
+        forward[k] = forward[k - 1] + arc_cost(cm, path[k - 1], path[k]);
+        backward[k] = backward[k - 1] + arc_cost(cm, path[k], path[k - 1]);
+    }
+
+    const cost_sum_t min_delta = -get_min_gain(path_cost(cm, path));
+    cost_sum_t best_delta = min_delta;
+    std::size_t best_i = 0;
+    std::size_t best_j = 0;
+    for (std::size_t i = 0; i + 2 < n; ++i)
+    {
+        const std::size_t a = path[i];
+        const std::size_t s = path[i + 1];
+        for (std::size_t j = i + 2; j < n; ++j)
+        {
+            const std::size_t e = path[j];
+            const std::size_t b = path[(j + 1) % n];
+            const cost_sum_t delta = arc_cost(cm, a, e) + arc_cost(cm, s, b)
+                                    - arc_cost(cm, a, s) - arc_cost(cm, e, b)
+                                    + (backward[j] - backward[i + 1]) - (forward[j] - forward[i + 1]);
+            if (delta < best_delta)
+            {
+                best_delta = delta;
+                best_i = i;
+                best_j = j;
+            }
+        }
+    }
+    if (best_delta == min_delta)
+    {
+        return false;
+    }
+    std::reverse(path.begin() + static_cast<std::ptrdiff_t>(best_i + 1),
+                 path.begin() + static_cast<std::ptrdiff_t>(best_j + 1));
+    return true;
+}
+
+/**
+ * Apply the best improving Or-opt move: move a segment of up to
+ * <tt>max_length</tt> cities (keeping its direction) to another place in the tour.
+ * @param cm The cost matrix.
+ * @param path
+ * @param max_length
+ * @return Whether the path was improved.
+ */
+bool improve_or_opt(const cost_matrix_t &cm, path_t &path, std::size_t max_length)
+{
+    const std::size_t n = path.size();
+    if (n < 4)
+    {
+        return false;
+    }
+    const cost_sum_t min_delta = -get_min_gain(path_cost(cm, path));
+    cost_sum_t best_delta = min_delta;
+    std::size_t best_i = 0;
+    std::size_t best_len = 0;
+    std::size_t best_k = 0;
+    for (std::size_t len = 1; len <= max_length && len + 2 <= n; ++len)
+    {
+        // The segment path[i..i+len-1] (cyclically) between p and q.
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const std::size_t s = path[i];
+            const std::size_t e = path[(i + len - 1) % n];
+            const std::size_t p = path[(i + n - 1) % n];
+            const std::size_t q = path[(i + len) % n];
+            const cost_sum_t removed = arc_cost(cm, p, s) + arc_cost(cm, e, q) - arc_cost(cm, p, q);
+            // Insert between path[k] and path[k+1], both outside the segment.
+            for (std::size_t offset = len; offset + 1 < n; ++offset)
+            {
+                const std::size_t k = (i + offset) % n;
+                const std::size_t x = path[k];
+                const std::size_t y = path[(k + 1) % n];
+                const cost_sum_t delta = arc_cost(cm, x, s) + arc_cost(cm, e, y) - arc_cost(cm, x, y) - removed;
+                if (delta < best_delta)
+                {
+                    best_delta = delta;
+                    best_i = i;
+                    best_len = len;
+                    best_k = k;
+                }
+            }
+        }
+    }
+    if (best_delta == min_delta)
+    {
+        return false;
+    }
+
+    // Rotate the segment to the front, then move it behind path[best_k].
+    path_t rotated(n);
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        rotated[k] = path[(best_i + k) % n];
+    }
+    const std::size_t target = (best_k + n - best_i) % n;
+    std::rotate(rotated.begin(), rotated.begin() + static_cast<std::ptrdiff_t>(best_len),
+                rotated.begin() + static_cast<std::ptrdiff_t>(target + 1));
+    std::rotate(rotated.begin(), std::find(rotated.begin(), rotated.end(), 1), rotated.end());
+    path = std::move(rotated);
+    return true;
+}
+
+/**
+ * Improve a tour with 2-opt and Or-opt moves until neither helps.
+ * @param cm The cost matrix.
+ * @param path A tour (starting at city 1).
+ * @return The improved tour and its cost (INF if the tour has forbidden transitions).
+ */
+tsp_solution_t get_improved_solution(const cost_matrix_t &cm, path_t path)
+{
+    // Moving longer segments than the classic three cities pays off on
+    // asymmetric matrices, where 2-opt moves (reversing a segment) rarely help.
+    constexpr std::size_t max_length = 10;
+    while (improve_two_opt(cm, path) || improve_or_opt(cm, path, max_length))
+    {
+    }
+    const std::size_t n = path.size();
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (is_inf(cm[path[k] - 1][path[(k + 1) % n] - 1]))
+        {
+            return {INF, path};
+        }
+    }
+    const cost_t cost = get_optimal_cost(path, cm);
+    return {cost, std::move(path)};
+}
+
+/**
+ * Find a good tour: the best of the nearest neighbour tours (from up to
+ * <tt>n_starts</tt> cities) and of the greedy edge tour, each improved with
+ * 2-opt and Or-opt moves until neither helps.
+ * @param cm The cost matrix.
+ * @return The tour and its cost (INF if the tour has forbidden transitions).
+ */
+tsp_solution_t get_heuristic_solution(const cost_matrix_t &cm)
+{
+    const std::size_t n = cm.size();
+    if (n < 2)
+    {
+        return {INF, {}};
+    }
+    constexpr std::size_t n_starts = 4;
+
+    std::vector<path_t> paths;
+    for (std::size_t k = 0; k < std::min(n, n_starts); ++k)
+    {
+        paths.push_back(get_nearest_neighbour_path(cm, k * n / std::min(n, n_starts)));
+    }
+    paths.push_back(get_greedy_edge_path(cm));
+
+    tsp_solution_t best{INF, {}};
+    cost_sum_t best_cost = 0;
+    for (path_t &path : paths)
+    {
+        tsp_solution_t solution = get_improved_solution(cm, std::move(path));
+        const cost_sum_t cost = path_cost(cm, solution.path);
+        if (best.path.empty() || cost < best_cost)
+        {
+            best = std::move(solution);
+            best_cost = cost;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,470 @@
+#include "tsp_kernels.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TSP_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/* Scalar */
+
+static cost_t scalar_row_min(const cost_t *row, std::size_t n)
+{
+    cost_t min = INF;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        min = std::min(min, row[i]);
+    }
+    return min;
+}
+
+static cost_t scalar_row_min_accumulate(const cost_t *row, std::size_t n, cost_t *col_min)
+{
+    cost_t min = INF;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        min = std::min(min, row[i]);
+        col_min[i] = std::min(col_min[i], row[i]);
+    }
+    return min;
+}
+
+static void scalar_row_subtract(cost_t *row, std::size_t n, cost_t value, cost_t *col_min)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!is_inf(row[i]))
+        {
+            row[i] -= value;
+        }
+        col_min[i] = std::min(col_min[i], row[i]);
+    }
+}
+
+static cost_t scalar_row_subtract_each(cost_t *row, std::size_t n, const cost_t *values)
+{
+    cost_t min = INF;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (!is_inf(row[i]))
+        {
+            row[i] -= values[i];
+        }
+        min = std::min(min, row[i]);
+    }
+    return min;
+}
+
+/**
+ * Add a value to a (first, second) pair of smallest values.
+ */
+static inline void push_two_smallest(cost_t v, cost_t &first, cost_t &second)
+{
+    second = std::min(second, std::max(first, v));
+    first = std::min(first, v);
+}
+
+static void scalar_two_smallest(const cost_t *row, std::size_t n, cost_t &first, cost_t &second,
+                                cost_t *col_first, cost_t *col_second)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        push_two_smallest(row[i], first, second);
+        push_two_smallest(row[i], col_first[i], col_second[i]);
+    }
+}
+
+/**
+ * The scalar min-plus step of the cells <tt>first..n-1</tt> (the tail of the vector loops).
+ */
+static void min_plus_from(std::size_t first, cost_t *row, std::size_t n, const cost_t *values,
+                          const cost_t *const *others, std::size_t n_values)
+{
+    for (std::size_t i = first; i < n; ++i)
+    {
+        cost_t min = INF;
+        for (std::size_t k = 0; k < n_values; ++k)
+        {
+            min = std::min(min, add_costs(values[k], others[k][i]));
+        }
+        row[i] = min;
+    }
+}
+
+static void scalar_min_plus(cost_t *row, std::size_t n, const cost_t *values, const cost_t *const *others,
+                            std::size_t n_values)
+{
+    min_plus_from(0, row, n, values, others, n_values);
+}
+
+static const cost_kernels_t scalar_kernels = {
+    scalar_row_min,
+    scalar_row_min_accumulate,
+    scalar_row_subtract,
+    scalar_row_subtract_each,
+    scalar_two_smallest,
+    scalar_min_plus,
+};
+
+#ifdef TSP_KERNELS_X86
+
+/*
+ * The vector kernels work on 32-bit integer lanes. They are templates of the
+ * cost type, so that they are only instantiated when the costs are such
+ * integers (@see: get_vector_kernels()); other cost types use the scalar kernels.
+ */
+
+template <typename C>
+constexpr C lane_inf = std::numeric_limits<C>::max();
+
+/**
+ * The largest cell to which <tt>value</tt> can be added without the sum
+ * reaching INF (smaller than INF, so that INF cells stay INF).
+ */
+template <typename C>
+static C min_plus_limit(C value)
+{
+    return value > 0 ? lane_inf<C> - value : lane_inf<C> - 1;
+}
+
+/* SSE4.1 (4 costs per vector) */
+
+template <typename C>
+__attribute__((target("sse4.1"))) static C sse_hmin(__m128i v)
+{
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_min_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static C sse_row_min(const C *row, std::size_t n)
+{
+    __m128i min = _mm_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        min = _mm_min_epi32(min, _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i)));
+    }
+    return std::min(sse_hmin<C>(min), scalar_row_min(row + i, n - i));
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static C sse_row_min_accumulate(const C *row, std::size_t n, C *col_min)
+{
+    __m128i min = _mm_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        auto *acc = reinterpret_cast<__m128i *>(col_min + i);
+        min = _mm_min_epi32(min, v);
+        _mm_storeu_si128(acc, _mm_min_epi32(_mm_loadu_si128(acc), v));
+    }
+    return std::min(sse_hmin<C>(min), scalar_row_min_accumulate(row + i, n - i, col_min + i));
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static void sse_row_subtract(C *row, std::size_t n, C value, C *col_min)
+{
+    const __m128i inf = _mm_set1_epi32(lane_inf<C>);
+    const __m128i sub = _mm_set1_epi32(value);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto *cells = reinterpret_cast<__m128i *>(row + i);
+        auto *acc = reinterpret_cast<__m128i *>(col_min + i);
+        const __m128i v = _mm_loadu_si128(cells);
+        const __m128i r = _mm_blendv_epi8(_mm_sub_epi32(v, sub), v, _mm_cmpeq_epi32(v, inf));
+        _mm_storeu_si128(cells, r);
+        _mm_storeu_si128(acc, _mm_min_epi32(_mm_loadu_si128(acc), r));
+    }
+    scalar_row_subtract(row + i, n - i, value, col_min + i);
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static C sse_row_subtract_each(C *row, std::size_t n, const C *values)
+{
+    const __m128i inf = _mm_set1_epi32(lane_inf<C>);
+    __m128i min = inf;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        auto *cells = reinterpret_cast<__m128i *>(row + i);
+        const __m128i v = _mm_loadu_si128(cells);
+        const __m128i sub = _mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i));
+        const __m128i r = _mm_blendv_epi8(_mm_sub_epi32(v, sub), v, _mm_cmpeq_epi32(v, inf));
+        _mm_storeu_si128(cells, r);
+        min = _mm_min_epi32(min, r);
+    }
+    return std::min(sse_hmin<C>(min), scalar_row_subtract_each(row + i, n - i, values + i));
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static void sse_two_smallest(const C *row, std::size_t n, C &first,
+                                                               C &second, C *col_first, C *col_second)
+{
+    __m128i first_v = _mm_set1_epi32(lane_inf<C>);
+    __m128i second_v = first_v;
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row + i));
+        auto *cf = reinterpret_cast<__m128i *>(col_first + i);
+        auto *cs = reinterpret_cast<__m128i *>(col_second + i);
+        const __m128i f = _mm_loadu_si128(cf);
+        _mm_storeu_si128(cs, _mm_min_epi32(_mm_loadu_si128(cs), _mm_max_epi32(f, v)));
+        _mm_storeu_si128(cf, _mm_min_epi32(f, v));
+        second_v = _mm_min_epi32(second_v, _mm_max_epi32(first_v, v));
+        first_v = _mm_min_epi32(first_v, v);
+    }
+    alignas(16) C lanes_first[4];
+    alignas(16) C lanes_second[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes_first), first_v);
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes_second), second_v);
+    for (std::size_t lane = 0; lane < 4; ++lane)
+    {
+        push_two_smallest(lanes_first[lane], first, second);
+        push_two_smallest(lanes_second[lane], first, second);
+    }
+    scalar_two_smallest(row + i, n - i, first, second, col_first + i, col_second + i);
+}
+
+template <typename C>
+__attribute__((target("sse4.1"))) static void sse_min_plus(C *row, std::size_t n, const C *values,
+                                                           const C *const *others, std::size_t n_values)
+{
+    const __m128i inf = _mm_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i min = inf;
+        for (std::size_t k = 0; k < n_values; ++k)
+        {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(others[k] + i));
+            const __m128i sum = _mm_blendv_epi8(_mm_add_epi32(v, _mm_set1_epi32(values[k])), inf,
+                                                _mm_cmpgt_epi32(v, _mm_set1_epi32(min_plus_limit(values[k]))));
+            min = _mm_min_epi32(min, sum);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), min);
+    }
+    min_plus_from(i, row, n, values, others, n_values);
+}
+
+template <typename C>
+const cost_kernels_t sse_kernels = {
+    sse_row_min<C>,
+    sse_row_min_accumulate<C>,
+    sse_row_subtract<C>,
+    sse_row_subtract_each<C>,
+    sse_two_smallest<C>,
+    sse_min_plus<C>,
+};
+
+/* AVX2 (8 costs per vector) */
+
+template <typename C>
+__attribute__((target("avx2"))) static C avx2_hmin(__m256i v)
+{
+    __m128i m = _mm_min_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_min_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static C avx2_row_min(const C *row, std::size_t n)
+{
+    __m256i min = _mm256_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        min = _mm256_min_epi32(min, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i)));
+    }
+    return std::min(avx2_hmin<C>(min), scalar_row_min(row + i, n - i));
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static C avx2_row_min_accumulate(const C *row, std::size_t n, C *col_min)
+{
+    __m256i min = _mm256_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        auto *acc = reinterpret_cast<__m256i *>(col_min + i);
+        min = _mm256_min_epi32(min, v);
+        _mm256_storeu_si256(acc, _mm256_min_epi32(_mm256_loadu_si256(acc), v));
+    }
+    return std::min(avx2_hmin<C>(min), scalar_row_min_accumulate(row + i, n - i, col_min + i));
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static void avx2_row_subtract(C *row, std::size_t n, C value, C *col_min)
+{
+    const __m256i inf = _mm256_set1_epi32(lane_inf<C>);
+    const __m256i sub = _mm256_set1_epi32(value);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        auto *cells = reinterpret_cast<__m256i *>(row + i);
+        auto *acc = reinterpret_cast<__m256i *>(col_min + i);
+        const __m256i v = _mm256_loadu_si256(cells);
+        const __m256i r = _mm256_blendv_epi8(_mm256_sub_epi32(v, sub), v, _mm256_cmpeq_epi32(v, inf));
+        _mm256_storeu_si256(cells, r);
+        _mm256_storeu_si256(acc, _mm256_min_epi32(_mm256_loadu_si256(acc), r));
+    }
+    scalar_row_subtract(row + i, n - i, value, col_min + i);
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static C avx2_row_subtract_each(C *row, std::size_t n, const C *values)
+{
+    const __m256i inf = _mm256_set1_epi32(lane_inf<C>);
+    __m256i min = inf;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        auto *cells = reinterpret_cast<__m256i *>(row + i);
+        const __m256i v = _mm256_loadu_si256(cells);
+        const __m256i sub = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i));
+        const __m256i r = _mm256_blendv_epi8(_mm256_sub_epi32(v, sub), v, _mm256_cmpeq_epi32(v, inf));
+        _mm256_storeu_si256(cells, r);
+        min = _mm256_min_epi32(min, r);
+    }
+    return std::min(avx2_hmin<C>(min), scalar_row_subtract_each(row + i, n - i, values + i));
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static void avx2_two_smallest(const C *row, std::size_t n, C &first,
+                                                              C &second, C *col_first, C *col_second)
+{
+    __m256i first_v = _mm256_set1_epi32(lane_inf<C>);
+    __m256i second_v = first_v;
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + i));
+        auto *cf = reinterpret_cast<__m256i *>(col_first + i);
+        auto *cs = reinterpret_cast<__m256i *>(col_second + i);
+        const __m256i f = _mm256_loadu_si256(cf);
+        _mm256_storeu_si256(cs, _mm256_min_epi32(_mm256_loadu_si256(cs), _mm256_max_epi32(f, v)));
+        _mm256_storeu_si256(cf, _mm256_min_epi32(f, v));
+        second_v = _mm256_min_epi32(second_v, _mm256_max_epi32(first_v, v));
+        first_v = _mm256_min_epi32(first_v, v);
+    }
+    alignas(32) C lanes_first[8];
+    alignas(32) C lanes_second[8];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes_first), first_v);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes_second), second_v);
+    for (std::size_t lane = 0; lane < 8; ++lane)
+    {
+        push_two_smallest(lanes_first[lane], first, second);
+        push_two_smallest(lanes_second[lane], first, second);
+    }
+    scalar_two_smallest(row + i, n - i, first, second, col_first + i, col_second + i);
+}
+
+template <typename C>
+__attribute__((target("avx2"))) static void avx2_min_plus(C *row, std::size_t n, const C *values,
+                                                          const C *const *others, std::size_t n_values)
+{
+    const __m256i inf = _mm256_set1_epi32(lane_inf<C>);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i min = inf;
+        for (std::size_t k = 0; k < n_values; ++k)
+        {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(others[k] + i));
+            const __m256i sum = _mm256_blendv_epi8(_mm256_add_epi32(v, _mm256_set1_epi32(values[k])), inf,
+                                                   _mm256_cmpgt_epi32(v, _mm256_set1_epi32(min_plus_limit(values[k]))));
+            min = _mm256_min_epi32(min, sum);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + i), min);
+    }
+    min_plus_from(i, row, n, values, others, n_values);
+}
+
+template <typename C>
+const cost_kernels_t avx2_kernels = {
+    avx2_row_min<C>,
+    avx2_row_min_accumulate<C>,
+    avx2_row_subtract<C>,
+    avx2_row_subtract_each<C>,
+    avx2_two_smallest<C>,
+    avx2_min_plus<C>,
+};
+
+/**
+ * @param level
+ * @return The vector kernels of the level for costs of type C (nullptr unless
+ *         they are 32-bit integers, or for the scalar level).
+ */
+template <typename C>
+static const cost_kernels_t *get_vector_kernels([[maybe_unused]] simd_level_t level)
+{
+    if constexpr (std::is_same<C, std::int32_t>::value)
+    {
+        switch (level)
+        {
+        case simd_level_t::AVX2:
+            return &avx2_kernels<C>;
+        case simd_level_t::SSE41:
+            return &sse_kernels<C>;
+        case simd_level_t::Scalar:
+            break;
+        }
+    }
+    return nullptr;
+}
+
+#endif // TSP_KERNELS_X86
+
+/**
+ * Check which instruction sets the CPU supports.
+ * @return The best supported instruction set.
+ */
+simd_level_t get_supported_simd_level()
+{
+#ifdef TSP_KERNELS_X86
+    if (get_vector_kernels<cost_t>(simd_level_t::SSE41) == nullptr)
+    {
+        return simd_level_t::Scalar;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return simd_level_t::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        return simd_level_t::SSE41;
+    }
+#endif
+    return simd_level_t::Scalar;
+}
+
+static simd_level_t current_level = get_supported_simd_level();
+
+simd_level_t get_simd_level() { return current_level; }
+
+simd_level_t set_simd_level(simd_level_t level)
+{
+    current_level = std::min(level, get_supported_simd_level());
+    return current_level;
+}
+
+const cost_kernels_t &get_cost_kernels()
+{
+#ifdef TSP_KERNELS_X86
+    if (const cost_kernels_t *kernels = get_vector_kernels<cost_t>(current_level))
+    {
+        return *kernels;
+    }
+#endif
+    return scalar_kernels;
+}
@@ -0,0 +1,786 @@
+#include "tsp_large.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+/// The costs of a matrix; INF counts as a very large, but finite, cost.
+struct matrix_distance_t {
+    const cost_matrix_t &cm;
+
+    cost_sum_t operator()(std::size_t from, std::size_t to) const
+    {
+        return is_inf(cm[from][to]) ? FORBIDDEN_COST : cm[from][to];
+    }
+    const cost_t *row(std::size_t from) const { return cm[from].data(); }
+};
+
+/// The costs of cities given by their coordinates, computed on demand.
+struct point_distance_t {
+    const PointDistances &distances;
+
+    cost_sum_t operator()(std::size_t from, std::size_t to) const { return distances(from, to); }
+    const cost_t *row(std::size_t from) const { return distances.row(from); }
+};
+
+/**
+ * Find the k cheapest successors of every city of a matrix.
+ * @param cm
+ * @param k
+ * @return The successors of city i at [i*k, (i+1)*k), cheapest first.
+ */
+std::vector<std::size_t> get_matrix_neighbours(const cost_matrix_t &cm, std::size_t k)
+{
+    const std::size_t n = cm.size();
+    std::vector<std::size_t> neighbours(n * k);
+    std::vector<std::size_t> others;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        others.clear();
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            if (j != i)
+            {
+                others.push_back(j);
+            }
+        }
+        auto cheaper = [&](std::size_t a, std::size_t b)
+        {
+            return std::make_pair(cm[i][a], a) < std::make_pair(cm[i][b], b);
+        };
+        std::partial_sort(others.begin(), others.begin() + static_cast<std::ptrdiff_t>(k), others.end(), cheaper);
+        std::copy(others.begin(), others.begin() + static_cast<std::ptrdiff_t>(k), neighbours.begin() + static_cast<std::ptrdiff_t>(i * k));
+    }
+    return neighbours;
+}
+
+/**
+ * Find the k cheapest predecessors of every city of a matrix.
+ * @param cm
+ * @param k
+ * @return The predecessors of city j at [j*k, (j+1)*k), cheapest first.
+ */
+std::vector<std::size_t> get_matrix_predecessors(const cost_matrix_t &cm, std::size_t k)
+{
+    const std::size_t n = cm.size();
+    cost_matrix_t transposed(n, std::vector<cost_t>(n));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            transposed[j][i] = cm[i][j];
+        }
+    }
+    return get_matrix_neighbours(transposed, k);
+}
+
+/**
+ * Find the k nearest cities of every point. The points are bucketed into a
+ * grid of about two points per cell, and the rings of cells around a point
+ * are searched until no point outside them can be nearer, so this takes
+ * about O(N k log k) instead of O(N^2).
+ * @param points
+ * @param k
+ * @return The neighbours of city i at [i*k, (i+1)*k), nearest first.
+ */
+std::vector<std::size_t> get_point_neighbours(const std::vector<point_t> &points, std::size_t k)
+{
+    const std::size_t n = points.size();
+    double min_x = points[0].x;
+    double max_x = points[0].x;
+    double min_y = points[0].y;
+    double max_y = points[0].y;
+    for (const point_t &p : points)
+    {
+        min_x = std::min(min_x, p.x);
+        max_x = std::max(max_x, p.x);
+        min_y = std::min(min_y, p.y);
+        max_y = std::max(max_y, p.y);
+    }
+    const std::size_t side = std::max<std::size_t>(1, static_cast<std::size_t>(std::sqrt(static_cast<double>(n) / 2)));
+    const double width = (max_x > min_x) ? (max_x - min_x) / static_cast<double>(side) : 1.0;
+    const double height = (max_y > min_y) ? (max_y - min_y) / static_cast<double>(side) : 1.0;
+    auto cell_of = [&](double value, double min_value, double size)
+    {
+        return std::min(side - 1, static_cast<std::size_t>((value - min_value) / size));
+    };
+
+    // Counting sort of the points by their cell.
+    std::vector<std::size_t> cell(n);
+    std::vector<std::size_t> cell_start(side * side + 1, 0);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        cell[i] = cell_of(points[i].y, min_y, height) * side + cell_of(points[i].x, min_x, width);
+        ++cell_start[cell[i] + 1];
+    }
+    std::partial_sum(cell_start.begin(), cell_start.end(), cell_start.begin());
+    std::vector<std::size_t> cell_points(n);
+    std::vector<std::size_t> fill(cell_start.begin(), cell_start.end() - 1);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        cell_points[fill[cell[i]]++] = i;
+    }
+
+    std::vector<std::size_t> neighbours(n * k);
+    std::vector<std::pair<double, std::size_t>> heap;
+    const double cell_size = std::min(width, height);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        heap.clear();
+        const long cx = static_cast<long>(cell[i] % side);
+        const long cy = static_cast<long>(cell[i] / side);
+        for (long r = 0; r <= static_cast<long>(side); ++r)
+        {
+            for (long y = cy - r; y <= cy + r; ++y)
+            {
+                for (long x = cx - r; x <= cx + r; ++x)
+                {
+                    const bool on_ring = (y == cy - r || y == cy + r || x == cx - r || x == cx + r);
+                    if (!on_ring || x < 0 || y < 0 || x >= static_cast<long>(side) || y >= static_cast<long>(side))
+                    {
+                        continue;
+                    }
+                    const std::size_t c = static_cast<std::size_t>(y) * side + static_cast<std::size_t>(x);
+                    for (std::size_t p = cell_start[c]; p < cell_start[c + 1]; ++p)
+                    {
+                        const std::size_t j = cell_points[p];
+                        if (j == i)
+                        {
+                            continue;
+                        }
+                        const double dx = points[i].x - points[j].x;
+                        const double dy = points[i].y - points[j].y;
+                        const std::pair<double, std::size_t> candidate(dx * dx + dy * dy, j);
+                        if (heap.size() < k)
+                        {
+                            heap.push_back(candidate);
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                        else if (candidate < heap.front())
+                        {
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = candidate;
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                    }
+                }
+            }
+            // Points outside the rings searched so far are at least r cells away.
+            const double reach = static_cast<double>(r) * cell_size;
+            if (heap.size() == k && heap.front().first <= reach * reach)
+            {
+                break;
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end());
+        for (std::size_t l = 0; l < k; ++l)
+        {
+            neighbours[i * k + l] = heap[l].second;
+        }
+    }
+    return neighbours;
+}
+
+/**
+ * Iterated local search on an array-based tour.
+ *
+ * The local search applies 2-opt moves (only if the costs are symmetric, as
+ * they reverse a part of the tour), Or-opt moves (a segment of up to three
+ * cities moved elsewhere) and segment swaps (the 3-opt move which keeps the
+ * direction of every part of the tour), connecting a city only to its
+ * nearest successors and predecessors. A city is examined again only when one of its
+ * edges changes ("don't look bits"). When no move helps, the tour is
+ * perturbed by a local double bridge (two adjacent segments swapped) and
+ * improved again; the result is kept unless it is worse, in which case the
+ * changes are undone from a journal.
+ */
+template <typename Distance>
+class LargeSearch {
+public:
+    /**
+     * @param n The number of cities.
+     * @param distance
+     * @param neighbours The k cheapest successors of every city.
+     * @param predecessors The k cheapest predecessors of every city (empty if the costs are symmetric).
+     * @param k
+     * @param options
+     */
+    LargeSearch(std::size_t n, Distance distance, std::vector<std::size_t> neighbours,
+                std::vector<std::size_t> predecessors, std::size_t k, const large_tsp_options_t &options)
+        : n_(n), dist_(distance), neighbours_(std::move(neighbours)), predecessors_(std::move(predecessors)),
+          k_(k), symmetric_(predecessors_.empty()), options_(options), rng_(options.seed) {}
+
+    path_t run(std::chrono::steady_clock::time_point start);
+    cost_sum_t get_cost() const { return cost_; }
+
+private:
+    std::size_t succ(std::size_t city) const { return tour_[pos_[city] + 1 == n_ ? 0 : pos_[city] + 1]; }
+    std::size_t pred(std::size_t city) const { return tour_[pos_[city] == 0 ? n_ - 1 : pos_[city] - 1]; }
+    const std::size_t *neighbours_of(std::size_t city) const { return neighbours_.data() + city * k_; }
+    const std::size_t *predecessors_of(std::size_t city) const
+    {
+        return (symmetric_ ? neighbours_.data() : predecessors_.data()) + city * k_;
+    }
+
+    void build_initial_tour();
+    void reverse_positions(std::size_t i, std::size_t j);
+    void reverse_path(std::size_t first, std::size_t last);
+    void rotate_block(std::size_t first, std::size_t mid, std::size_t last);
+    void push(std::size_t city);
+    bool improve_two_opt(std::size_t a);
+    bool improve_or_opt(std::size_t a);
+    bool improve_segment_swap(std::size_t a);
+    void local_search();
+    void kick();
+    void undo();
+
+    std::size_t n_;
+    Distance dist_;
+    std::vector<std::size_t> neighbours_;
+    std::vector<std::size_t> predecessors_;
+    std::size_t k_;
+    bool symmetric_;
+    large_tsp_options_t options_;
+    std::mt19937 rng_;
+
+    std::vector<std::size_t> tour_;
+    std::vector<std::size_t> pos_;
+    cost_sum_t cost_ = 0;
+    std::deque<std::size_t> queue_;
+    std::vector<unsigned char> queued_;
+    /// The old city at every position written since the last accepted tour
+    /// (only while perturbing, as the first local search is never undone).
+    std::vector<std::pair<std::size_t, std::size_t>> journal_;
+    bool recording_ = false;
+};
+
+/**
+ * Build a nearest neighbour tour from city 0, looking at the candidate lists
+ * first and at all unvisited cities only if every candidate is visited.
+ */
+template <typename Distance>
+void LargeSearch<Distance>::build_initial_tour()
+{
+    std::vector<std::size_t> unvisited(n_);
+    std::vector<std::size_t> where(n_);
+    std::iota(unvisited.begin(), unvisited.end(), 0);
+    std::iota(where.begin(), where.end(), 0);
+    auto visit = [&](std::size_t city)
+    {
+        const std::size_t last = unvisited.back();
+        unvisited[where[city]] = last;
+        where[last] = where[city];
+        unvisited.pop_back();
+        where[city] = npos;
+        tour_.push_back(city);
+    };
+
+    tour_.clear();
+    visit(0);
+    while (!unvisited.empty())
+    {
+        const std::size_t city = tour_.back();
+        std::size_t next = npos;
+        for (std::size_t l = 0; l < k_ && next == npos; ++l)
+        {
+            if (where[neighbours_of(city)[l]] != npos)
+            {
+                next = neighbours_of(city)[l];
+            }
+        }
+        if (next == npos)
+        {
+            const cost_t *costs = dist_.row(city);
+            for (std::size_t other : unvisited)
+            {
+                if (next == npos || costs[other] < costs[next])
+                {
+                    next = other;
+                }
+            }
+        }
+        visit(next);
+    }
+
+    pos_.resize(n_);
+    cost_ = 0;
+    for (std::size_t i = 0; i < n_; ++i)
+    {
+        pos_[tour_[i]] = i;
+        cost_ += dist_(tour_[i], tour_[(i + 1) % n_]);
+    }
+}
+
+/**
+ * Reverse the cities at positions i..j of the tour (going forward, possibly
+ * past the end of the array), recording the old ones in the journal.
+ */
+template <typename Distance>
+void LargeSearch<Distance>::reverse_positions(std::size_t i, std::size_t j)
+{
+    const std::size_t length = (j + n_ - i) % n_ + 1;
+    for (std::size_t step = 0; step < length / 2; ++step)
+    {
+        const std::size_t a = tour_[i];
+        const std::size_t b = tour_[j];
+        if (recording_)
+        {
+            journal_.emplace_back(i, a);
+            journal_.emplace_back(j, b);
+        }
+        tour_[i] = b;
+        pos_[b] = i;
+        tour_[j] = a;
+        pos_[a] = j;
+        i = (i + 1 == n_) ? 0 : i + 1;
+        j = (j == 0) ? n_ - 1 : j - 1;
+    }
+}
+
+/**
+ * Reverse the path from <tt>first</tt> forward to <tt>last</tt>. On symmetric
+ * costs, reversing the rest of the tour instead gives the same tour, so the
+ * shorter of the two is reversed.
+ */
+template <typename Distance>
+void LargeSearch<Distance>::reverse_path(std::size_t first, std::size_t last)
+{
+    const std::size_t i = pos_[first];
+    const std::size_t j = pos_[last];
+    const std::size_t length = (j + n_ - i) % n_ + 1;
+    if (2 * length <= n_)
+    {
+        reverse_positions(i, j);
+    }
+    else if (length < n_)
+    {
+        reverse_positions((j + 1) % n_, (i + n_ - 1) % n_);
+    }
+}
+
+/**
+ * Swap the paths first..(mid-1) and mid..last (both going forward) with
+ * three reversals, keeping the direction of each.
+ */
+template <typename Distance>
+void LargeSearch<Distance>::rotate_block(std::size_t first, std::size_t mid, std::size_t last)
+{
+    const std::size_t i = pos_[first];
+    const std::size_t m = pos_[mid];
+    const std::size_t l = pos_[last];
+    reverse_positions(i, (m + n_ - 1) % n_);
+    reverse_positions(m, l);
+    reverse_positions(i, l);
+}
+
+/// Examine the city again (clear its don't look bit).
+template <typename Distance>
+void LargeSearch<Distance>::push(std::size_t city)
+{
+    if (!queued_[city])
+    {
+        queued_[city] = 1;
+        queue_.push_back(city);
+    }
+}
+
+/**
+ * Apply the first improving 2-opt move replacing an edge of the city by an
+ * edge to one of its neighbours, in both directions of the tour.
+ * @return Whether the tour was improved.
+ */
+template <typename Distance>
+bool LargeSearch<Distance>::improve_two_opt(std::size_t a)
+{
+    for (int direction = 0; direction < 2; ++direction)
+    {
+        const std::size_t b = (direction == 0) ? succ(a) : pred(a);
+        const cost_sum_t d_ab = dist_(a, b);
+        for (std::size_t l = 0; l < k_; ++l)
+        {
+            const std::size_t c = neighbours_of(a)[l];
+            const cost_sum_t d_ac = dist_(a, c);
+            // The new edge alone must be shorter than the removed one.
+            if (d_ac >= d_ab)
+            {
+                break;
+            }
+            const std::size_t d = (direction == 0) ? succ(c) : pred(c);
+            if (c == b || d == a)
+            {
+                continue;
+            }
+            const cost_sum_t delta = d_ac + dist_(b, d) - d_ab - dist_(c, d);
+            if (delta < 0)
+            {
+                // a b ... c d -> a c ... b d (or the same backwards).
+                if (direction == 0)
+                {
+                    reverse_path(b, c);
+                }
+                else
+                {
+                    reverse_path(a, d);
+                }
+                cost_ += delta;
+                for (std::size_t city : {a, b, c, d})
+                {
+                    push(city);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Apply the first improving Or-opt move of a segment starting at the city:
+ * insert it between a neighbour of its last city and that neighbour's
+ * predecessor (or, on symmetric costs, between a neighbour of its first
+ * city and that neighbour's successor).
+ * @return Whether the tour was improved.
+ */
+template <typename Distance>
+bool LargeSearch<Distance>::improve_or_opt(std::size_t a)
+{
+    for (std::size_t length = 1; length <= 3 && length + 3 <= n_; ++length)
+    {
+        const std::size_t s1 = a;
+        std::size_t s2 = a;
+        for (std::size_t step = 1; step < length; ++step)
+        {
+            s2 = succ(s2);
+        }
+        const std::size_t p = pred(s1);
+        const std::size_t q = succ(s2);
+        const cost_sum_t gain = dist_(p, s1) + dist_(s2, q) - dist_(p, q);
+        if (gain <= 0)
+        {
+            continue;
+        }
+        auto in_segment = [&](std::size_t city) { return (pos_[city] + n_ - pos_[s1]) % n_ < length; };
+
+        for (int side = 0; side < (symmetric_ ? 2 : 1); ++side)
+        {
+            const std::size_t from = (side == 0) ? s2 : s1;
+            for (std::size_t l = 0; l < k_; ++l)
+            {
+                const std::size_t neighbour = neighbours_of(from)[l];
+                if (dist_(from, neighbour) >= gain)
+                {
+                    break;
+                }
+                // Insert between x and y = succ(x).
+                const std::size_t x = (side == 0) ? pred(neighbour) : neighbour;
+                const std::size_t y = (side == 0) ? neighbour : succ(neighbour);
+                if (in_segment(x) || in_segment(y))
+                {
+                    continue;
+                }
+                const cost_sum_t delta = dist_(x, s1) + dist_(s2, y) - dist_(x, y) - gain;
+                if (delta < 0)
+                {
+                    // Move the segment forward (past q..x) or backward (before y..p),
+                    // whichever rewrites fewer positions.
+                    const std::size_t forward = (pos_[x] + n_ - pos_[s1]) % n_;
+                    const std::size_t backward = (pos_[s2] + n_ - pos_[y]) % n_;
+                    if (forward <= backward)
+                    {
+                        rotate_block(s1, q, x);
+                    }
+                    else
+                    {
+                        rotate_block(y, s1, s2);
+                    }
+                    cost_ += delta;
+                    for (std::size_t city : {p, q, s1, s2, x, y})
+                    {
+                        push(city);
+                    }
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Apply the first improving segment swap leaving the city towards one of its
+ * neighbours: a1 [b1 .. a2] [b2 .. a3] b3 -> a1 [b2 .. a3] [b1 .. a2] b3,
+ * with a1 = a, b2 a neighbour of a1 and a3 a predecessor of b1.
+ * @return Whether the tour was improved.
+ */
+template <typename Distance>
+bool LargeSearch<Distance>::improve_segment_swap(std::size_t a)
+{
+    if (n_ < 6)
+    {
+        return false;
+    }
+    const std::size_t a1 = a;
+    const std::size_t b1 = succ(a1);
+    const cost_sum_t d_a1b1 = dist_(a1, b1);
+    auto offset = [&](std::size_t city) { return (pos_[city] + n_ - pos_[a1]) % n_; };
+    for (std::size_t l = 0; l < k_; ++l)
+    {
+        const std::size_t b2 = neighbours_of(a1)[l];
+        const cost_sum_t d_a1b2 = dist_(a1, b2);
+        if (d_a1b2 >= d_a1b1)
+        {
+            break;
+        }
+        if (b2 == b1)
+        {
+            continue;
+        }
+        const std::size_t a2 = pred(b2);
+        // What the new edges into b1 and out of a2 may cost at most.
+        const cost_sum_t budget = d_a1b1 - d_a1b2 + dist_(a2, b2);
+        for (std::size_t m = 0; m < k_; ++m)
+        {
+            const std::size_t a3 = predecessors_of(b1)[m];
+            const cost_sum_t d_a3b1 = dist_(a3, b1);
+            if (d_a3b1 >= budget)
+            {
+                break;
+            }
+            // a3 must lie in b2 .. (a1 - 1), so that the three parts are nonempty.
+            if (a3 == a1 || offset(a3) < offset(b2))
+            {
+                continue;
+            }
+            const std::size_t b3 = succ(a3);
+            const cost_sum_t delta = d_a1b2 + d_a3b1 + dist_(a2, b3) - d_a1b1 - dist_(a2, b2) - dist_(a3, b3);
+            if (delta < 0)
+            {
+                // Swapping any two adjacent parts of the three gives the same
+                // tour, so the pair with the fewest cities is rotated.
+                const std::size_t l1 = offset(a2);
+                const std::size_t l2 = offset(a3) - offset(a2);
+                const std::size_t l3 = n_ - l1 - l2;
+                if (l1 + l2 <= std::min(l2 + l3, l3 + l1))
+                {
+                    rotate_block(b1, b2, a3);
+                }
+                else if (l2 + l3 <= l3 + l1)
+                {
+                    rotate_block(b2, b3, a1);
+                }
+                else
+                {
+                    rotate_block(b3, b1, a2);
+                }
+                cost_ += delta;
+                for (std::size_t city : {a1, b1, a2, b2, a3, b3})
+                {
+                    push(city);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/// Improve the tour until no city in the queue has an improving move.
+template <typename Distance>
+void LargeSearch<Distance>::local_search()
+{
+    while (!queue_.empty())
+    {
+        const std::size_t a = queue_.front();
+        queue_.pop_front();
+        queued_[a] = 0;
+        if ((symmetric_ && improve_two_opt(a)) || improve_or_opt(a) || improve_segment_swap(a))
+        {
+            push(a);
+        }
+    }
+}
+
+/// Swap two short adjacent segments of the tour at a random place.
+template <typename Distance>
+void LargeSearch<Distance>::kick()
+{
+    const std::size_t max_length = std::min<std::size_t>(50, n_ / 4);
+    std::uniform_int_distribution<std::size_t> position(0, n_ - 1);
+    std::uniform_int_distribution<std::size_t> segment(1, max_length);
+    const std::size_t i = position(rng_);
+    const std::size_t l1 = segment(rng_);
+    const std::size_t l2 = segment(rng_);
+    // a [b1 .. b2] [c1 .. c2] d -> a [c1 .. c2] [b1 .. b2] d
+    const std::size_t a = tour_[i];
+    const std::size_t b1 = tour_[(i + 1) % n_];
+    const std::size_t b2 = tour_[(i + l1) % n_];
+    const std::size_t c1 = tour_[(i + l1 + 1) % n_];
+    const std::size_t c2 = tour_[(i + l1 + l2) % n_];
+    const std::size_t d = tour_[(i + l1 + l2 + 1) % n_];
+    cost_ += dist_(a, c1) + dist_(c2, b1) + dist_(b2, d) - dist_(a, b1) - dist_(b2, c1) - dist_(c2, d);
+    rotate_block(b1, c1, c2);
+    for (std::size_t city : {a, b1, b2, c1, c2, d})
+    {
+        push(city);
+    }
+}
+
+/// Restore the tour as it was when the journal was last cleared.
+template <typename Distance>
+void LargeSearch<Distance>::undo()
+{
+    for (auto it = journal_.rbegin(); it != journal_.rend(); ++it)
+    {
+        tour_[it->first] = it->second;
+        pos_[it->second] = it->first;
+    }
+    journal_.clear();
+}
+
+/**
+ * @param start When the solver was called (the time limit counts from it).
+ * @return The best tour found (0-based, starting at city 0).
+ */
+template <typename Distance>
+path_t LargeSearch<Distance>::run(std::chrono::steady_clock::time_point start)
+{
+    build_initial_tour();
+    queued_.assign(n_, 0);
+    if (n_ >= 4)
+    {
+        for (std::size_t city : tour_)
+        {
+            push(city);
+        }
+        local_search();
+    }
+    recording_ = true;
+
+    const auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(options_.time_limit));
+    for (std::size_t kicks = 0; n_ >= 8 && (options_.max_kicks == 0 || kicks < options_.max_kicks); ++kicks)
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+        const cost_sum_t old_cost = cost_;
+        kick();
+        local_search();
+        if (cost_ > old_cost)
+        {
+            undo();
+            cost_ = old_cost;
+        }
+        journal_.clear();
+    }
+
+    std::rotate(tour_.begin(), std::find(tour_.begin(), tour_.end(), 0), tour_.end());
+    return tour_;
+}
+
+/**
+ * Convert the cost of a tour summed in <tt>cost_sum_t</tt> into a cost.
+ * @return The cost, or INF if it does not fit into <tt>cost_t</tt> (as
+ *   get_optimal_cost() reports such tours).
+ */
+cost_t to_tour_cost(cost_sum_t cost)
+{
+    return cost >= static_cast<cost_sum_t>(INF) ? INF : static_cast<cost_t>(cost);
+}
+
+/**
+ * Convert a 0-based tour into a path of the solver (1-based).
+ */
+path_t to_path(path_t tour)
+{
+    for (std::size_t &city : tour)
+    {
+        ++city;
+    }
+    return tour;
+}
+
+} // namespace
+
+/**
+ * Find a good tour of a large instance given as a matrix.
+ * @param cm The cost matrix.
+ * @param options
+ * @return The tour (starting at city 1) and its cost (INF if the tour has
+ *   forbidden transitions or costs at least INF).
+ */
+tsp_solution_t solve_tsp_large(const cost_matrix_t &cm, const large_tsp_options_t &options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t n = cm.size();
+    if (n == 0)
+    {
+        return {INF, {}};
+    }
+    bool symmetric = true;
+    for (std::size_t i = 0; i < n && symmetric; ++i)
+    {
+        for (std::size_t j = i + 1; j < n && symmetric; ++j)
+        {
+            symmetric = (cm[i][j] == cm[j][i]);
+        }
+    }
+    const std::size_t k = std::min(options.n_neighbours, n - 1);
+    LargeSearch<matrix_distance_t> search(n, matrix_distance_t{cm}, get_matrix_neighbours(cm, k),
+                                          symmetric ? std::vector<std::size_t>() : get_matrix_predecessors(cm, k),
+                                          k, options);
+    const path_t path = to_path(search.run(start));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        if (is_inf(cm[path[i] - 1][path[(i + 1) % n] - 1]))
+        {
+            return {INF, path};
+        }
+    }
+    return {to_tour_cost(search.get_cost()), path};
+}
+
+/**
+ * Find a good tour through cities given by their coordinates, without
+ * building their matrix.
+ * @param distances
+ * @param options
+ * @return The tour (starting at city 1) and its cost (INF if it costs at least INF).
+ */
+tsp_solution_t solve_tsp_large(const PointDistances &distances, const large_tsp_options_t &options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const std::size_t n = distances.size();
+    if (n == 0)
+    {
+        return {INF, {}};
+    }
+    const std::size_t k = std::min(options.n_neighbours, n - 1);
+    LargeSearch<point_distance_t> search(n, point_distance_t{distances},
+                                         get_point_neighbours(distances.get_points(), k), {}, k, options);
+    const path_t path = to_path(search.run(start));
+    return {to_tour_cost(search.get_cost()), path};
+}
+
+/**
+ * Find a good tour through points, with their distances rounded to the
+ * nearest integer (as EUC_2D in TSPLIB).
+ * @param points
+ * @param options
+ * @return The tour (starting at city 1) and its cost.
+ */
+tsp_solution_t solve_tsp_large(const std::vector<point_t> &points, const large_tsp_options_t &options)
+{
+    return solve_tsp_large(PointDistances(points), options);
+}
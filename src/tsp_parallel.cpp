@@ -0,0 +1,250 @@
+#include "TSP.hpp"
+#include "tsp_pool.hpp"
+#include "tsp_search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * The stages owned by one worker. The owner pushes and pops at the back
+ * (depth first); other workers steal from the front, where the shallowest
+ * stages (the largest subtrees) are.
+ */
+class WorkQueue {
+public:
+    void push(search_node_t &&task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+
+    bool pop(search_node_t &task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+        {
+            return false;
+        }
+        task = std::move(tasks_.back());
+        tasks_.pop_back();
+        return true;
+    }
+
+    bool steal(search_node_t &task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+        {
+            return false;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+        return true;
+    }
+
+    /// The lowest lower bound of the stages in the queue (INF if none).
+    cost_t min_lower_bound()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cost_t lb = INF;
+        for (const search_node_t &task : tasks_)
+        {
+            lb = std::min(lb, task.stage.get_lower_bound());
+        }
+        return lb;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<search_node_t> tasks_;
+};
+
+/**
+ * Branch & bound shared by several threads. Every worker dives from its
+ * stages like the sequential solver and puts the right branches into its own
+ * queue; idle workers steal from the others. The best cost is shared, so all
+ * workers prune against the best tour found by any of them. Once a limit is
+ * reached, every worker finishes its dive and stops.
+ */
+class ParallelSearch {
+public:
+    ParallelSearch(const cost_matrix_t &cm, const tsp_options_t &options, std::size_t n_threads, MatrixPool &pool,
+                   cost_t upper_bound)
+        : cm_(cm), options_(options), pool_(pool), n_levels_(cm.size() - 2), bound_(options.bound),
+          stats_(options.stats), limits_(options), outcome_(options.outcome), tours_(options, upper_bound),
+          queues_(n_threads), worker_stats_(n_threads) {}
+
+    tsp_solutions_t run();
+
+private:
+    void work(std::size_t id);
+    bool next_task(std::size_t id, search_node_t &task);
+    void push(std::size_t id, search_node_t &&task);
+
+    const cost_matrix_t &cm_;
+    const tsp_options_t &options_;
+    MatrixPool &pool_;
+    const std::size_t n_levels_;
+    const IBoundingEngine *bound_;
+    search_stats_t *stats_;
+    StatsRecorder::clock::time_point start_ = StatsRecorder::clock::now();
+    const SearchLimits limits_;
+    search_outcome_t *outcome_;
+
+    TourCollector tours_;
+    // The number of tasks pushed and not yet fully searched.
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> n_nodes_{0};
+    // Set once a limit is reached.
+    std::atomic<bool> stopped_{false};
+
+    std::vector<WorkQueue> queues_;
+    // Every worker records its own statistics, merged into stats_ at the end.
+    std::vector<search_stats_t> worker_stats_;
+};
+
+tsp_solutions_t ParallelSearch::run()
+{
+    push(0, {get_root_stage(cm_, options_, pool_), {}});
+
+    std::vector<std::thread> workers;
+    for (std::size_t id = 1; id < queues_.size(); ++id)
+    {
+        workers.emplace_back(&ParallelSearch::work, this, id);
+    }
+    work(0);
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+    if (stats_ != nullptr)
+    {
+        for (const search_stats_t &stats : worker_stats_)
+        {
+            stats_->merge(stats);
+        }
+    }
+    if (stopped_.load())
+    {
+        cost_t open_lb = INF;
+        for (WorkQueue &queue : queues_)
+        {
+            open_lb = std::min(open_lb, queue.min_lower_bound());
+        }
+        stop_search(outcome_, open_lb);
+    }
+
+    // The optimal tours in the order the sequential search finds them.
+    return tours_.take();
+}
+
+void ParallelSearch::push(std::size_t id, search_node_t &&task)
+{
+    pending_.fetch_add(1);
+    queues_[id].push(std::move(task));
+}
+
+/**
+ * Take the next task: the newest own one, or the oldest one of another worker.
+ * @return False once no task is left anywhere or a limit is reached.
+ */
+bool ParallelSearch::next_task(std::size_t id, search_node_t &task)
+{
+    const std::size_t n_workers = queues_.size();
+    while (true)
+    {
+        if (stopped_.load(std::memory_order_relaxed) || limits_.reached(n_nodes_.load(std::memory_order_relaxed)))
+        {
+            stopped_.store(true);
+            return false;
+        }
+        if (queues_[id].pop(task))
+        {
+            return true;
+        }
+        for (std::size_t i = 1; i < n_workers; ++i)
+        {
+            if (queues_[(id + i) % n_workers].steal(task))
+            {
+                return true;
+            }
+        }
+        if (pending_.load() == 0)
+        {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
+
+void ParallelSearch::work(std::size_t id)
+{
+    StatsRecorder recorder(stats_ != nullptr ? &worker_stats_[id] : nullptr, start_);
+    search_node_t task{StageState(CostMatrix()), {}};
+    while (next_task(id, task))
+    {
+        StageState &left_branch = task.stage;
+        std::vector<bool> &branches = task.branches;
+
+        auto push_right = [this, id, &branches, &recorder](StageState &&right_branch)
+        {
+            std::vector<bool> right_branches(branches);
+            right_branches.push_back(true);
+            push(id, {std::move(right_branch), std::move(right_branches)});
+            recorder.waiting(pending_.load(std::memory_order_relaxed));
+        };
+
+        step_result_t result;
+        std::size_t n_nodes = 0;
+        while ((result = branch_step(left_branch, n_levels_, tours_.bound(), push_right, bound_, recorder)) ==
+               step_result_t::Branched)
+        {
+            branches.push_back(false);
+            ++n_nodes;
+        }
+        n_nodes_.fetch_add(n_nodes, std::memory_order_relaxed);
+
+        tsp_solution_t solution;
+        if (result == step_result_t::Leaf && close_leaf(left_branch, cm_, tours_.bound(), solution, recorder))
+        {
+            const cost_t cost = solution.lower_bound;
+            if (tours_.add(std::move(solution), std::move(branches)))
+            {
+                recorder.incumbent(cost);
+            }
+        }
+        pending_.fetch_sub(1);
+    }
+}
+
+} // namespace
+
+/**
+ * Solve the TSP with several threads.
+ * @param cm The cost matrix.
+ * @param options The number of threads (0 = one per hardware thread), the bounding engine, the limits,
+ *                the statistics, the outcome and the tours to keep.
+ * @param pool The buffers for the matrices of the search tree.
+ * @param upper_bound The cost of a known tour (INF if none).
+ * @return A list of optimal solutions, in the same order as solve_tsp() gives them.
+ */
+tsp_solutions_t solve_tsp_parallel(const cost_matrix_t &cm, const tsp_options_t &options, MatrixPool &pool,
+                                   cost_t upper_bound)
+{
+    if (cm.size() < 2)
+    {
+        return {};
+    }
+    std::size_t n_threads = options.n_threads;
+    if (n_threads == 0)
+    {
+        n_threads = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+    }
+    return ParallelSearch(cm, options, n_threads, pool, upper_bound).run();
+}
@@ -0,0 +1,79 @@
+#include "tsp_pool.hpp"
+#include "TSP.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+/**
+ * Create an empty pool.
+ * @param n The size of the largest matrix a buffer has to hold.
+ */
+MatrixPool::MatrixPool(std::size_t n)
+    : matrix_size_(n), block_bytes_(CostMatrix::block_bytes(n)) {}
+
+MatrixPool::~MatrixPool()
+{
+    for (void *block : free_)
+    {
+        std::free(block);
+    }
+}
+
+/**
+ * Borrow a buffer, allocating a new one only if none is free.
+ * @return A buffer of block_bytes() bytes, aligned to CostMatrix::alignment.
+ */
+void *MatrixPool::acquire()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    void *block;
+    if (free_.empty())
+    {
+        block = std::aligned_alloc(CostMatrix::alignment, block_bytes_);
+        if (block == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        ++allocated_;
+        // Make room for every buffer, so that giving one back never allocates.
+        free_.reserve(allocated_);
+    }
+    else
+    {
+        block = free_.back();
+        free_.pop_back();
+    }
+    ++in_use_;
+    high_water_mark_ = std::max(high_water_mark_, in_use_);
+    return block;
+}
+
+/**
+ * Give back a buffer borrowed with acquire().
+ * @param block
+ */
+void MatrixPool::release(void *block)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back(block);
+    --in_use_;
+}
+
+std::size_t MatrixPool::in_use() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_use_;
+}
+
+std::size_t MatrixPool::allocated() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocated_;
+}
+
+std::size_t MatrixPool::high_water_mark() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return high_water_mark_;
+}
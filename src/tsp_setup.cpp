@@ -5,3 +5,12 @@
 #include "tsp_setup.hpp"
 
 bool is_inf(cost_t val) { return val == INF; }
+
+cost_t add_costs(cost_t a, cost_t b)
+{
+    if (is_inf(a) || is_inf(b) || (b > 0 && a >= INF - b))
+    {
+        return INF;
+    }
+    return static_cast<cost_t>(a + b);
+}
@@ -0,0 +1,423 @@
+#include "TSP.hpp"
+#include "tsp_search.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+/// A change to the working state, undone when the search backtracks.
+struct trail_entry_t {
+    enum class Kind {
+        /// A cell was overwritten; <tt>value</tt> is its old value.
+        Cell,
+        /// <tt>value</tt> was subtracted from the finite cells of a row.
+        ReduceRow,
+        /// <tt>value</tt> was subtracted from the finite cells of a column.
+        ReduceCol,
+        /// The row at <tt>position</tt> of the live rows was removed.
+        RemoveRow,
+        /// The column at <tt>position</tt> of the live columns was removed.
+        RemoveCol
+    };
+
+    Kind kind;
+    std::size_t index;
+    cost_t value;
+    std::size_t position;
+};
+
+/**
+ * Depth-first branch & bound on a single N x N matrix.
+ *
+ * Instead of copying the matrix for every stage, every change (forbidden
+ * cells, reductions, removed rows and columns) is recorded in a trail and
+ * undone when the search backtracks, so a stage costs only the changes made
+ * in it. The stages are visited, and the vertices chosen, exactly as in
+ * solve_tsp().
+ */
+class TrailSearch {
+public:
+    TrailSearch(const cost_matrix_t &cm, const tsp_options_t &options, cost_t upper_bound);
+
+    tsp_solutions_t run(search_outcome_t *outcome);
+
+private:
+    cost_t &cell(std::size_t r, std::size_t c) { return cells_[r * n_ + c]; }
+
+    void search(std::size_t level, cost_t lb);
+    void set(std::size_t r, std::size_t c, cost_t value);
+    cost_t reduce();
+    NewVertex choose_new_vertex();
+    void include(vertex_t v);
+    void close_tour();
+    void undo(std::size_t mark);
+
+    const cost_matrix_t &cm_;
+    const std::size_t n_;
+    std::vector<cost_t> cells_;
+
+    // Rows and columns not yet chosen, in ascending order.
+    std::vector<std::size_t> rows_;
+    std::vector<std::size_t> cols_;
+    // The chosen transitions (npos if none).
+    std::vector<std::size_t> succ_;
+    std::vector<std::size_t> pred_;
+
+    std::vector<trail_entry_t> trail_;
+    std::vector<cost_t> row_second_;
+    std::vector<cost_t> col_first_;
+    std::vector<cost_t> col_second_;
+
+    TourCollector tours_;
+    // Whether the tours going the reverse way round are skipped (@see: create_right_branch_matrix()).
+    const bool skip_reversed_;
+    StatsRecorder stats_;
+    const SearchLimits limits_;
+    std::size_t n_nodes_ = 0;
+    bool stopped_ = false;
+    // The lowest lower bound of the stages left open once stopped.
+    cost_t open_lb_ = INF;
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+};
+
+TrailSearch::TrailSearch(const cost_matrix_t &cm, const tsp_options_t &options, cost_t upper_bound)
+    : cm_(cm), n_(cm.size()), cells_(n_ * n_), succ_(n_, npos), pred_(n_, npos), tours_(options, upper_bound),
+      skip_reversed_(options.skip_reversed_tours && is_symmetric(cm)), stats_(options.stats), limits_(options)
+{
+    for (std::size_t r = 0; r < n_; ++r)
+    {
+        std::copy(cm[r].cbegin(), cm[r].cend(), cells_.begin() + static_cast<std::ptrdiff_t>(r * n_));
+        rows_.push_back(r);
+        cols_.push_back(r);
+    }
+}
+
+/**
+ * @param outcome Where a stop by a limit is recorded (nullptr if nowhere).
+ */
+tsp_solutions_t TrailSearch::run(search_outcome_t *outcome)
+{
+    search(0, 0);
+    if (stopped_)
+    {
+        stop_search(outcome, open_lb_);
+    }
+    return tours_.take();
+}
+
+/**
+ * Search the stage at the given level: its left branches recursively, then
+ * its right branches (the same stage with the chosen vertex forbidden).
+ * Leaves the working state as it found it. Once a limit is reached, every
+ * stage on the way from the root gives up its right branches.
+ * @param level The number of vertices in the path.
+ * @param lb The lower bound of the stage.
+ */
+void TrailSearch::search(std::size_t level, cost_t lb)
+{
+    const std::size_t mark = trail_.size();
+    // The stages on the way from the root (the right branches of a stage reuse its level).
+    stats_.waiting(level + 1);
+    while (!exceeds_bound(lb, tours_.bound()))
+    {
+        stopped_ = stopped_ || limits_.reached(n_nodes_);
+        if (stopped_)
+        {
+            open_lb_ = std::min(open_lb_, lb);
+            break;
+        }
+        if (level == n_ - 2)
+        {
+            close_tour();
+            break;
+        }
+
+        auto start = stats_.now();
+        lb = add_costs(lb, reduce());
+        stats_.add_time(&search_stats_t::reduction_seconds, start);
+        if (exceeds_bound(lb, tours_.bound()))
+        {
+            stats_.pruned();
+            break;
+        }
+        start = stats_.now();
+        NewVertex new_vertex = choose_new_vertex();
+        stats_.add_time(&search_stats_t::selection_seconds, start);
+        if (new_vertex.cost == -INF)
+        {
+            stats_.pruned();
+            break;
+        }
+        stats_.expanded();
+        ++n_nodes_;
+
+        const std::size_t branch = trail_.size();
+        start = stats_.now();
+        include(new_vertex.coordinates);
+        stats_.add_time(&search_stats_t::update_seconds, start);
+        search(level + 1, lb);
+        undo(branch);
+        succ_[new_vertex.coordinates.row] = npos;
+        pred_[new_vertex.coordinates.col] = npos;
+
+        if (is_inf(new_vertex.cost) || exceeds_bound(add_costs(lb, new_vertex.cost), tours_.bound()))
+        {
+            stats_.pruned();
+            break;
+        }
+        set(new_vertex.coordinates.row, new_vertex.coordinates.col, INF);
+        if (skip_reversed_ && level == 0)
+        {
+            set(new_vertex.coordinates.col, new_vertex.coordinates.row, INF);
+        }
+    }
+    undo(mark);
+}
+
+/**
+ * Overwrite a cell, recording its old value.
+ * @param r
+ * @param c
+ * @param value
+ */
+void TrailSearch::set(std::size_t r, std::size_t c, cost_t value)
+{
+    cost_t &target = cell(r, c);
+    if (target != value)
+    {
+        trail_.push_back({trail_entry_t::Kind::Cell, r * n_ + c, target, 0});
+        target = value;
+    }
+}
+
+/**
+ * Reduce the live columns, then the live rows (skipping lines without a
+ * finite cell), recording every reduced line.
+ * @return The sum of reduced values.
+ */
+cost_t TrailSearch::reduce()
+{
+    cost_t reduced = 0;
+    for (std::size_t c : cols_)
+    {
+        cost_t min = INF;
+        for (std::size_t r : rows_)
+        {
+            min = std::min(min, cell(r, c));
+        }
+        if (min == 0 || is_inf(min))
+        {
+            continue;
+        }
+        for (std::size_t r : rows_)
+        {
+            if (!is_inf(cell(r, c)))
+            {
+                cell(r, c) -= min;
+            }
+        }
+        trail_.push_back({trail_entry_t::Kind::ReduceCol, c, min, 0});
+        reduced = add_costs(reduced, min);
+    }
+    for (std::size_t r : rows_)
+    {
+        cost_t min = INF;
+        for (std::size_t c : cols_)
+        {
+            min = std::min(min, cell(r, c));
+        }
+        if (min == 0 || is_inf(min))
+        {
+            continue;
+        }
+        for (std::size_t c : cols_)
+        {
+            if (!is_inf(cell(r, c)))
+            {
+                cell(r, c) -= min;
+            }
+        }
+        trail_.push_back({trail_entry_t::Kind::ReduceRow, r, min, 0});
+        reduced = add_costs(reduced, min);
+    }
+    return reduced;
+}
+
+/**
+ * Choose the zero with the highest cost of not choosing it, the same way as
+ * StageState::choose_new_vertex() does.
+ * @return The vertex (with cost -INF if the matrix has no zero).
+ */
+NewVertex TrailSearch::choose_new_vertex()
+{
+    // Only rows with a zero matter, so a row's cost is its second smallest value.
+    row_second_.assign(rows_.size(), INF);
+    col_first_.assign(cols_.size(), INF);
+    col_second_.assign(cols_.size(), INF);
+    for (std::size_t i = 0; i < rows_.size(); ++i)
+    {
+        cost_t first = INF;
+        for (std::size_t j = 0; j < cols_.size(); ++j)
+        {
+            const cost_t value = cell(rows_[i], cols_[j]);
+            row_second_[i] = std::min(row_second_[i], std::max(first, value));
+            first = std::min(first, value);
+            col_second_[j] = std::min(col_second_[j], std::max(col_first_[j], value));
+            col_first_[j] = std::min(col_first_[j], value);
+        }
+    }
+
+    NewVertex result({0, 0}, -INF);
+    for (std::size_t i = 0; i < rows_.size(); ++i)
+    {
+        for (std::size_t j = 0; j < cols_.size(); ++j)
+        {
+            if (cell(rows_[i], cols_[j]) == 0)
+            {
+                const cost_t vert_cost = add_costs(row_second_[i], col_second_[j]);
+                if (vert_cost > result.cost)
+                {
+                    result = NewVertex(vertex_t(rows_[i], cols_[j]), vert_cost);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Add the vertex to the path: forbid closing a subtour with its fragment and
+ * remove its row and column.
+ * @param v
+ */
+void TrailSearch::include(vertex_t v)
+{
+    succ_[v.row] = v.col;
+    pred_[v.col] = v.row;
+    std::size_t begin = v.row;
+    while (pred_[begin] != npos)
+    {
+        begin = pred_[begin];
+    }
+    std::size_t end = v.col;
+    while (succ_[end] != npos)
+    {
+        end = succ_[end];
+    }
+    set(end, begin, INF);
+
+    auto row_it = std::lower_bound(rows_.begin(), rows_.end(), v.row);
+    trail_.push_back({trail_entry_t::Kind::RemoveRow, v.row, 0, static_cast<std::size_t>(row_it - rows_.begin())});
+    rows_.erase(row_it);
+    auto col_it = std::lower_bound(cols_.begin(), cols_.end(), v.col);
+    trail_.push_back({trail_entry_t::Kind::RemoveCol, v.col, 0, static_cast<std::size_t>(col_it - cols_.begin())});
+    cols_.erase(col_it);
+}
+
+/**
+ * Close the path with the last two rows and columns (@see: StageState::get_path())
+ * and save the tour if it is at most as expensive as the best one.
+ */
+void TrailSearch::close_tour()
+{
+    const std::size_t r0 = rows_[0];
+    const std::size_t r1 = rows_[1];
+    const std::size_t c0 = cols_[0];
+    const std::size_t c1 = cols_[1];
+    const bool straight = !is_inf(cell(r0, c0)) && !is_inf(cell(r1, c1));
+    const bool crossed = !is_inf(cell(r0, c1)) && !is_inf(cell(r1, c0));
+
+    std::vector<std::size_t> next(succ_);
+    if (straight && (!crossed || static_cast<cost_sum_t>(cell(r0, c0)) + cell(r1, c1) <=
+                                 static_cast<cost_sum_t>(cell(r0, c1)) + cell(r1, c0)))
+    {
+        next[r0] = c0;
+        next[r1] = c1;
+    }
+    else if (crossed)
+    {
+        next[r0] = c1;
+        next[r1] = c0;
+    }
+    else
+    {
+        return;
+    }
+
+    const auto start = stats_.now();
+    path_t path({1});
+    for (std::size_t city = next[0]; city != 0; city = next[city])
+    {
+        path.push_back(city + 1);
+    }
+    const cost_t cost = get_optimal_cost(path, cm_);
+    stats_.add_time(&search_stats_t::path_seconds, start);
+    if (!is_inf(cost) && tours_.add({cost, std::move(path)}))
+    {
+        stats_.incumbent(cost);
+    }
+}
+
+/**
+ * Undo the changes recorded since the given trail size, newest first.
+ * @param mark
+ */
+void TrailSearch::undo(std::size_t mark)
+{
+    while (trail_.size() > mark)
+    {
+        const trail_entry_t entry = trail_.back();
+        trail_.pop_back();
+        switch (entry.kind)
+        {
+            case trail_entry_t::Kind::Cell:
+                cells_[entry.index] = entry.value;
+                break;
+            case trail_entry_t::Kind::ReduceRow:
+                for (std::size_t c : cols_)
+                {
+                    if (!is_inf(cell(entry.index, c)))
+                    {
+                        cell(entry.index, c) += entry.value;
+                    }
+                }
+                break;
+            case trail_entry_t::Kind::ReduceCol:
+                for (std::size_t r : rows_)
+                {
+                    if (!is_inf(cell(r, entry.index)))
+                    {
+                        cell(r, entry.index) += entry.value;
+                    }
+                }
+                break;
+            case trail_entry_t::Kind::RemoveRow:
+                rows_.insert(rows_.begin() + static_cast<std::ptrdiff_t>(entry.position), entry.index);
+                break;
+            case trail_entry_t::Kind::RemoveCol:
+                cols_.insert(cols_.begin() + static_cast<std::ptrdiff_t>(entry.position), entry.index);
+                break;
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * Solve the TSP depth first on a single working matrix, undoing the changes
+ * made in a stage when backtracking from it.
+ * @param cm The cost matrix.
+ * @param options The limits, the statistics, the outcome and the tours to keep.
+ * @param upper_bound The cost of a known tour (INF if none).
+ * @return A list of optimal solutions, in the same order as solve_tsp() gives them.
+ */
+tsp_solutions_t solve_tsp_trail(const cost_matrix_t &cm, const tsp_options_t &options, cost_t upper_bound)
+{
+    if (cm.size() < 2)
+    {
+        return {};
+    }
+    return TrailSearch(cm, options, upper_bound).run(options.outcome);
+}
@@ -0,0 +1,381 @@
+#include "tsp_tsplib.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+/// A file mapped read-only into memory for as long as the object lives.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *begin() const { return data_; }
+    const char *end() const { return data_ + size_; }
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+MappedFile::MappedFile(const std::string &path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0)
+    {
+        ::close(fd);
+        throw std::runtime_error("cannot read " + path);
+    }
+    size_ = static_cast<std::size_t>(info.st_size);
+    if (size_ > 0)
+    {
+        void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            ::close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        ::madvise(data, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(data);
+    }
+    ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(const_cast<char *>(data_), size_);
+    }
+}
+
+/// Reads lines, keywords and numbers from a buffer, without copying them.
+class Reader {
+public:
+    Reader(const char *begin, const char *end) : p_(begin), end_(end) {}
+
+    bool at_end()
+    {
+        skip_spaces();
+        return p_ == end_;
+    }
+
+    /// The rest of the current line, without the surrounding spaces.
+    std::string_view line()
+    {
+        skip_spaces();
+        const char *start = p_;
+        while (p_ != end_ && *p_ != '\n')
+        {
+            ++p_;
+        }
+        return trim(std::string_view(start, static_cast<std::size_t>(p_ - start)));
+    }
+
+    template <typename T>
+    T number()
+    {
+        skip_spaces();
+        T value{};
+        // from_chars does not accept a leading '+'.
+        const char *start = (p_ != end_ && *p_ == '+') ? p_ + 1 : p_;
+        const auto result = std::from_chars(start, end_, value);
+        if (result.ec != std::errc())
+        {
+            throw std::runtime_error("TSPLIB: expected a number at \"" + std::string(line()) + "\"");
+        }
+        p_ = result.ptr;
+        return value;
+    }
+
+    static std::string_view trim(std::string_view text)
+    {
+        const auto first = text.find_first_not_of(" \t\r");
+        if (first == std::string_view::npos)
+        {
+            return {};
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+
+private:
+    void skip_spaces()
+    {
+        while (p_ != end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\r' || *p_ == '\n'))
+        {
+            ++p_;
+        }
+    }
+
+    const char *p_;
+    const char *end_;
+};
+
+/// Which cells of the matrix EDGE_WEIGHT_SECTION lists, row by row (EDGE_WEIGHT_FORMAT).
+enum class weight_format_t {
+    FullMatrix,
+    UpperRow,
+    LowerRow,
+    UpperDiagRow,
+    LowerDiagRow
+};
+
+weight_format_t parse_weight_format(std::string_view value)
+{
+    if (value == "FULL_MATRIX")
+    {
+        return weight_format_t::FullMatrix;
+    }
+    if (value == "UPPER_ROW")
+    {
+        return weight_format_t::UpperRow;
+    }
+    if (value == "LOWER_ROW")
+    {
+        return weight_format_t::LowerRow;
+    }
+    if (value == "UPPER_DIAG_ROW")
+    {
+        return weight_format_t::UpperDiagRow;
+    }
+    if (value == "LOWER_DIAG_ROW")
+    {
+        return weight_format_t::LowerDiagRow;
+    }
+    throw std::runtime_error("TSPLIB: unsupported EDGE_WEIGHT_FORMAT " + std::string(value));
+}
+
+tsplib_weight_type_t parse_weight_type(std::string_view value)
+{
+    if (value == "EXPLICIT")
+    {
+        return tsplib_weight_type_t::Explicit;
+    }
+    if (value == "EUC_2D")
+    {
+        return tsplib_weight_type_t::Euc2D;
+    }
+    if (value == "CEIL_2D")
+    {
+        return tsplib_weight_type_t::Ceil2D;
+    }
+    if (value == "GEO")
+    {
+        return tsplib_weight_type_t::Geo;
+    }
+    throw std::runtime_error("TSPLIB: unsupported EDGE_WEIGHT_TYPE " + std::string(value));
+}
+
+/**
+ * Read EDGE_WEIGHT_SECTION into the rows of the matrix, mirroring the
+ * triangular formats.
+ */
+void read_weights(Reader &reader, weight_format_t format, cost_matrix_t &matrix)
+{
+    const std::size_t n = matrix.size();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::size_t first = 0;
+        std::size_t last = n;
+        switch (format)
+        {
+            case weight_format_t::FullMatrix:
+                break;
+            case weight_format_t::UpperRow:
+                first = i + 1;
+                break;
+            case weight_format_t::LowerRow:
+                last = i;
+                break;
+            case weight_format_t::UpperDiagRow:
+                first = i;
+                break;
+            case weight_format_t::LowerDiagRow:
+                last = i + 1;
+                break;
+        }
+        for (std::size_t j = first; j < last; ++j)
+        {
+            matrix[i][j] = reader.number<cost_t>();
+            if (format != weight_format_t::FullMatrix)
+            {
+                matrix[j][i] = matrix[i][j];
+            }
+        }
+    }
+}
+
+/**
+ * Convert a TSPLIB DDD.MM coordinate into radians.
+ */
+double geo_radians(double value)
+{
+    constexpr double pi = 3.141592;
+    const double degrees = std::trunc(value);
+    return pi * (degrees + 5.0 * (value - degrees) / 3.0) / 180.0;
+}
+
+} // namespace
+
+/**
+ * Load a TSPLIB file (TSP or ATSP) with EXPLICIT, EUC_2D, CEIL_2D or GEO
+ * weights. The file is mapped into memory and the numbers are parsed in
+ * place, so the only allocations are those of the result.
+ * @param path
+ * @return The instance (the diagonal of an EXPLICIT matrix is set to INF).
+ * @throw std::runtime_error If the file cannot be read or is not a supported instance.
+ */
+tsplib_instance_t load_tsplib(const std::string &path)
+{
+    const MappedFile file(path);
+    Reader reader(file.begin(), file.end());
+
+    tsplib_instance_t instance;
+    std::size_t dimension = 0;
+    weight_format_t format = weight_format_t::FullMatrix;
+    while (!reader.at_end())
+    {
+        const std::string_view line = reader.line();
+        const auto colon = line.find(':');
+        const std::string_view key = Reader::trim(line.substr(0, colon));
+        const std::string_view value = (colon == std::string_view::npos) ? std::string_view()
+                                                                          : Reader::trim(line.substr(colon + 1));
+        if (key == "NAME")
+        {
+            instance.name = std::string(value);
+        }
+        else if (key == "TYPE")
+        {
+            if (value != "TSP" && value != "ATSP")
+            {
+                throw std::runtime_error("TSPLIB: unsupported TYPE " + std::string(value));
+            }
+        }
+        else if (key == "DIMENSION")
+        {
+            Reader number(value.data(), value.data() + value.size());
+            dimension = number.number<std::size_t>();
+        }
+        else if (key == "EDGE_WEIGHT_TYPE")
+        {
+            instance.weight_type = parse_weight_type(value);
+        }
+        else if (key == "EDGE_WEIGHT_FORMAT")
+        {
+            format = parse_weight_format(value);
+        }
+        else if (key == "EDGE_WEIGHT_SECTION")
+        {
+            instance.matrix.assign(dimension, std::vector<cost_t>(dimension));
+            read_weights(reader, format, instance.matrix);
+            for (std::size_t i = 0; i < dimension; ++i)
+            {
+                instance.matrix[i][i] = INF;
+            }
+        }
+        else if (key == "NODE_COORD_SECTION" || key == "DISPLAY_DATA_SECTION")
+        {
+            std::vector<point_t> points(dimension);
+            for (std::size_t k = 0; k < dimension; ++k)
+            {
+                const std::size_t index = reader.number<std::size_t>();
+                if (index < 1 || index > dimension)
+                {
+                    throw std::runtime_error("TSPLIB: node " + std::to_string(index) + " out of range");
+                }
+                points[index - 1].x = reader.number<double>();
+                points[index - 1].y = reader.number<double>();
+            }
+            if (key == "NODE_COORD_SECTION")
+            {
+                instance.points = std::move(points);
+            }
+        }
+        else if (key == "EOF")
+        {
+            break;
+        }
+    }
+
+    if (instance.weight_type == tsplib_weight_type_t::Explicit ? instance.matrix.empty() : instance.points.empty())
+    {
+        throw std::runtime_error("TSPLIB: " + path + " has no " +
+                                 (instance.weight_type == tsplib_weight_type_t::Explicit ? "EDGE_WEIGHT_SECTION"
+                                                                                         : "NODE_COORD_SECTION"));
+    }
+    return instance;
+}
+
+/**
+ * The cost of going from one city to another, as defined by TSPLIB.
+ * @param instance
+ * @param from The city (0-based).
+ * @param to The city (0-based).
+ * @return The cost (INF if <tt>from == to</tt>).
+ */
+cost_t get_tsplib_distance(const tsplib_instance_t &instance, std::size_t from, std::size_t to)
+{
+    if (from == to)
+    {
+        return INF;
+    }
+    if (instance.weight_type == tsplib_weight_type_t::Explicit)
+    {
+        return instance.matrix[from][to];
+    }
+    const point_t &a = instance.points[from];
+    const point_t &b = instance.points[to];
+    switch (instance.weight_type)
+    {
+        case tsplib_weight_type_t::Euc2D:
+            return get_distance(a, b, rounding_t::Nearest);
+        case tsplib_weight_type_t::Ceil2D:
+            return get_distance(a, b, rounding_t::Up);
+        default:
+        {
+            constexpr double earth_radius = 6378.388;
+            const double q1 = std::cos(geo_radians(a.y) - geo_radians(b.y));
+            const double q2 = std::cos(geo_radians(a.x) - geo_radians(b.x));
+            const double q3 = std::cos(geo_radians(a.x) + geo_radians(b.x));
+            return static_cast<cost_t>(std::trunc(earth_radius * std::acos(0.5 * ((1.0 + q1) * q2 - (1.0 - q1) * q3)) + 1.0));
+        }
+    }
+}
+
+/**
+ * @param instance
+ * @return The cost matrix of the instance (with INF on the diagonal).
+ */
+cost_matrix_t get_cost_matrix(const tsplib_instance_t &instance)
+{
+    if (instance.weight_type == tsplib_weight_type_t::Explicit)
+    {
+        return instance.matrix;
+    }
+    const std::size_t n = instance.size();
+    cost_matrix_t matrix(n, std::vector<cost_t>(n));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            matrix[i][j] = get_tsplib_distance(instance, i, j);
+        }
+    }
+    return matrix;
+}
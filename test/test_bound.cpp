@@ -0,0 +1,205 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_bound.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+/**
+ * Build a symmetric matrix of rounded distances between random points.
+ */
+static cost_matrix_t euclidean_matrix(std::size_t n, std::mt19937 &rng)
+{
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        x[i] = static_cast<double>(rng() % 100);
+        y[i] = static_cast<double>(rng() % 100);
+    }
+    cost_matrix_t m(n, std::vector<cost_t>(n, INF));
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            if (i != j)
+            {
+                m[i][j] = static_cast<cost_t>(std::lround(std::hypot(x[i] - x[j], y[i] - y[j])));
+            }
+        }
+    }
+    return m;
+}
+
+TEST(BoundTest, one_tree_at_root)
+{
+    std::mt19937 rng(13);
+    const OneTreeBound one_tree;
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm = euclidean_matrix(12, rng);
+        const cost_t optimal = solve_tsp(cm).front().lower_bound;
+
+        StageState root(CostMatrix(cm), {}, 0, StageState::Layout::Shrinking);
+        root.update_lower_bound(root.reduce_cost_matrix());
+        const cost_t bound = one_tree.get_lower_bound(root, optimal);
+
+        ASSERT_GE(bound, root.get_reduction_sum());
+        ASSERT_LE(bound, optimal);
+        ASSERT_FALSE(root.get_bound_state().penalties.empty());
+    }
+}
+
+TEST(BoundTest, same_solutions)
+{
+    std::mt19937 rng(14);
+    const OneTreeBound one_tree;
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm = euclidean_matrix(10, rng);
+        tsp_options_t defaults;
+        defaults.engine = tsp_engine_t::BranchAndBound;
+        tsp_solutions_t expected = solve_tsp(cm, defaults);
+
+        for (std::size_t n_threads : {1, 2})
+        {
+            tsp_options_t options = defaults;
+            options.bound = &one_tree;
+            options.n_threads = n_threads;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            ASSERT_EQ(solutions.size(), expected.size());
+            for (std::size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].lower_bound, expected[i].lower_bound);
+                ASSERT_EQ(solutions[i].path, expected[i].path);
+            }
+        }
+    }
+}
+
+TEST(BoundTest, fractional_costs)
+{
+    // The bounds must not round fractional costs (in floating-point builds) up past the optimum
+    std::mt19937 rng(16);
+    std::uniform_real_distribution<double> uniform(0, 10);
+    const OneTreeBound one_tree;
+    const AssignmentBound assignment;
+    for (int trial = 0; trial < 200; ++trial)
+    {
+        const std::size_t n = 5 + static_cast<std::size_t>(trial % 6);
+        cost_matrix_t cm(n, std::vector<cost_t>(n, INF));
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            for (std::size_t j = i + 1; j < n; ++j)
+            {
+                cm[i][j] = cm[j][i] = static_cast<cost_t>(uniform(rng));
+            }
+        }
+        tsp_options_t held_karp;
+        held_karp.engine = tsp_engine_t::HeldKarp;
+        const double optimal = static_cast<double>(solve_tsp(cm, held_karp).front().lower_bound);
+
+        for (const IBoundingEngine *bound : {static_cast<const IBoundingEngine *>(&one_tree),
+                                             static_cast<const IBoundingEngine *>(&assignment)})
+        {
+            tsp_options_t options;
+            options.engine = tsp_engine_t::BranchAndBound;
+            options.warm_start = false;
+            options.bound = bound;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            ASSERT_FALSE(solutions.empty());
+            ASSERT_NEAR(static_cast<double>(solutions.front().lower_bound), optimal, 1e-5 * optimal);
+        }
+    }
+}
+
+TEST(BoundTest, assignment_at_root)
+{
+    std::mt19937 rng(15);
+    const AssignmentBound assignment;
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm(12, std::vector<cost_t>(12, INF));
+        for (std::size_t i = 0; i < cm.size(); ++i)
+        {
+            for (std::size_t j = 0; j < cm.size(); ++j)
+            {
+                cm[i][j] = (i == j) ? INF : static_cast<cost_t>(rng() % 100);
+            }
+        }
+        const cost_t optimal = solve_tsp(cm).front().lower_bound;
+
+        StageState root(CostMatrix(cm), {}, 0, StageState::Layout::Shrinking);
+        const cost_t reduction = root.reduce_cost_matrix();
+        root.update_lower_bound(reduction);
+        const cost_t bound = assignment.get_lower_bound(root, optimal);
+
+        ASSERT_GE(bound, reduction);
+        ASSERT_LE(bound, optimal);
+        ASSERT_EQ(bound, root.get_reduction_sum());
+        // The potentials are folded into the matrix: every row keeps a zero.
+        for (std::size_t i = 0; i < cm.size(); ++i)
+        {
+            const cost_t *row = root.get_matrix()[i];
+            ASSERT_EQ(*std::min_element(row, row + cm.size()), 0);
+        }
+    }
+}
+
+TEST(BoundTest, potentials_saturate)
+{
+    // Every cell keeps a non-negative reduced cost, but the potentials add up past INF
+    const cost_t quarter = static_cast<cost_t>(INF / 4);
+    cost_matrix_t cm(3, std::vector<cost_t>(3, static_cast<cost_t>(INF / 2)));
+    for (std::size_t i = 0; i < cm.size(); ++i)
+    {
+        cm[i][i] = INF;
+    }
+    StageState stage(CostMatrix(cm), {}, 0, StageState::Layout::Shrinking);
+    stage.apply_potentials(std::vector<cost_t>(3, quarter), std::vector<cost_t>(3, quarter));
+
+    ASSERT_TRUE(is_inf(stage.get_reduction_sum()));
+}
+
+TEST(BoundTest, assignment_same_solutions)
+{
+    std::mt19937 rng(16);
+    const AssignmentBound assignment;
+    auto by_path = [](const tsp_solution_t &a, const tsp_solution_t &b) { return a.path < b.path; };
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm(9, std::vector<cost_t>(9, INF));
+        for (std::size_t i = 0; i < cm.size(); ++i)
+        {
+            for (std::size_t j = 0; j < cm.size(); ++j)
+            {
+                if (i != j && rng() % 5 != 0)
+                {
+                    cm[i][j] = static_cast<cost_t>(rng() % 10);
+                }
+            }
+        }
+        tsp_solutions_t expected = solve_tsp(cm);
+        std::sort(expected.begin(), expected.end(), by_path);
+
+        for (std::size_t n_threads : {1, 2})
+        {
+            tsp_options_t options;
+            options.bound = &assignment;
+            options.n_threads = n_threads;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+            std::sort(solutions.begin(), solutions.end(), by_path);
+
+            ASSERT_EQ(solutions.size(), expected.size());
+            for (std::size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].lower_bound, expected[i].lower_bound);
+                ASSERT_EQ(solutions[i].path, expected[i].path);
+            }
+        }
+    }
+}
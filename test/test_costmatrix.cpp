@@ -1,19 +1,21 @@
 #include "gtest/gtest.h"
 #include "TSP.hpp"
+#include "tsp_pool.hpp"
 #include <vector>
+#include <cstdint>
 
 TEST(CostMatrixTest, get_min_values_in_rows)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 2, 8, 4};
-    std::vector<int> v2{1, 1, 3, 4};
-    std::vector<int> v3{3, 8, INF, 7};
-    std::vector<int> v4{INF, INF, INF, INF};
+    std::vector<cost_t> v1{INF, 2, 8, 4};
+    std::vector<cost_t> v2{1, 1, 3, 4};
+    std::vector<cost_t> v3{3, 8, INF, 7};
+    std::vector<cost_t> v4{INF, INF, INF, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4};
     CostMatrix matrix(cost_matrix);
 
     // Sprawdzenie minimalnych wartosci w macierzy w wierszach
-    std::vector<int> v = matrix.get_min_values_in_rows();
+    std::vector<cost_t> v = matrix.get_min_values_in_rows();
     ASSERT_EQ(v[0], 2);
     ASSERT_EQ(v[1], 1);
     ASSERT_EQ(v[2], 3);
@@ -23,15 +25,15 @@ TEST(CostMatrixTest, get_min_values_in_rows)
 TEST(CostMatrixTest, get_min_values_in_cols)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 2, 8, INF};
-    std::vector<int> v2{1, 1, 3, INF};
-    std::vector<int> v3{3, 8, INF, INF};
-    std::vector<int> v4{8, 3, INF, INF};
+    std::vector<cost_t> v1{INF, 2, 8, INF};
+    std::vector<cost_t> v2{1, 1, 3, INF};
+    std::vector<cost_t> v3{3, 8, INF, INF};
+    std::vector<cost_t> v4{8, 3, INF, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4};
     CostMatrix matrix(cost_matrix);
 
     // Sprawdzenie minimalnych wartosci w macierzy w kolumnach
-    std::vector<int> v = matrix.get_min_values_in_cols();
+    std::vector<cost_t> v = matrix.get_min_values_in_cols();
     ASSERT_EQ(v[0], 1);
     ASSERT_EQ(v[1], 1);
     ASSERT_EQ(v[2], 3);
@@ -41,11 +43,11 @@ TEST(CostMatrixTest, get_min_values_in_cols)
 TEST(CostMatrixTest, reduce_rows)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 10, 8, 19, 12};
-    std::vector<int> v2{10, INF, 20, 6, 3};
-    std::vector<int> v3{8, 20, INF, 4, 2};
-    std::vector<int> v4{19, 6, 4, INF, 7};
-    std::vector<int> v5{12, 3, 2, 7, INF};
+    std::vector<cost_t> v1{INF, 10, 8, 19, 12};
+    std::vector<cost_t> v2{10, INF, 20, 6, 3};
+    std::vector<cost_t> v3{8, 20, INF, 4, 2};
+    std::vector<cost_t> v4{19, 6, 4, INF, 7};
+    std::vector<cost_t> v5{12, 3, 2, 7, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
 
@@ -57,11 +59,11 @@ TEST(CostMatrixTest, reduce_rows)
     cost_matrix_t m = matrix.get_matrix();
 
     // Sprawdzenie każdej wartości zaktulizowanej macierzy
-    std::vector<int> v1_new{INF, 2, 0, 11, 4};
-    std::vector<int> v2_new{7, INF, 17, 3, 0};
-    std::vector<int> v3_new{6, 18, INF, 2, 0};
-    std::vector<int> v4_new{15, 2, 0, INF, 3};
-    std::vector<int> v5_new{10, 1, 0, 5, INF};
+    std::vector<cost_t> v1_new{INF, 2, 0, 11, 4};
+    std::vector<cost_t> v2_new{7, INF, 17, 3, 0};
+    std::vector<cost_t> v3_new{6, 18, INF, 2, 0};
+    std::vector<cost_t> v4_new{15, 2, 0, INF, 3};
+    std::vector<cost_t> v5_new{10, 1, 0, 5, INF};
 
     ASSERT_EQ(m[0], v1_new);
     ASSERT_EQ(m[1], v2_new);
@@ -73,11 +75,11 @@ TEST(CostMatrixTest, reduce_rows)
 TEST(CostMatrixTest, reduce_cols)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 2, 0, 11, 4};
-    std::vector<int> v2{7, INF, 17, 3, 0};
-    std::vector<int> v3{6, 18, INF, 2, 0};
-    std::vector<int> v4{15, 2, 0, INF, 3};
-    std::vector<int> v5{10, 1, 0, 5, INF};
+    std::vector<cost_t> v1{INF, 2, 0, 11, 4};
+    std::vector<cost_t> v2{7, INF, 17, 3, 0};
+    std::vector<cost_t> v3{6, 18, INF, 2, 0};
+    std::vector<cost_t> v4{15, 2, 0, INF, 3};
+    std::vector<cost_t> v5{10, 1, 0, 5, INF};
 
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
@@ -90,11 +92,11 @@ TEST(CostMatrixTest, reduce_cols)
     cost_matrix_t m = matrix.get_matrix();
 
     // Sprawdzenie każdej wartości zaktulizowanej macierzy
-    std::vector<int> v1_new{INF, 1, 0, 9, 4};
-    std::vector<int> v2_new{1, INF, 17, 1, 0};
-    std::vector<int> v3_new{0, 17, INF, 0, 0};
-    std::vector<int> v4_new{9, 1, 0, INF, 3};
-    std::vector<int> v5_new{4, 0, 0, 3, INF};
+    std::vector<cost_t> v1_new{INF, 1, 0, 9, 4};
+    std::vector<cost_t> v2_new{1, INF, 17, 1, 0};
+    std::vector<cost_t> v3_new{0, 17, INF, 0, 0};
+    std::vector<cost_t> v4_new{9, 1, 0, INF, 3};
+    std::vector<cost_t> v5_new{4, 0, 0, 3, INF};
 
     ASSERT_EQ(m[0], v1_new);
     ASSERT_EQ(m[1], v2_new);
@@ -106,11 +108,11 @@ TEST(CostMatrixTest, reduce_cols)
 TEST(CostMatrixTest, get_vertex_cost)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 1, 0, 9, 4};
-    std::vector<int> v2{1, INF, 17, 1, 0};
-    std::vector<int> v3{0, 17, INF, 0, 0};
-    std::vector<int> v4{9, 1, 0, INF, 3};
-    std::vector<int> v5{4, 0, 0, 3, INF};
+    std::vector<cost_t> v1{INF, 1, 0, 9, 4};
+    std::vector<cost_t> v2{1, INF, 17, 1, 0};
+    std::vector<cost_t> v3{0, 17, INF, 0, 0};
+    std::vector<cost_t> v4{9, 1, 0, INF, 3};
+    std::vector<cost_t> v5{4, 0, 0, 3, INF};
 
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
@@ -123,4 +125,123 @@ TEST(CostMatrixTest, get_vertex_cost)
     ASSERT_EQ(1, matrix.get_vertex_cost(2, 3));
     ASSERT_EQ(1, matrix.get_vertex_cost(3, 2));
     ASSERT_EQ(0, matrix.get_vertex_cost(4, 2));
-}
\ No newline at end of file
+}
+TEST(CostMatrixTest, flat_storage)
+{
+    cost_matrix_t cost_matrix{{INF, 1, 2},
+                              {3, INF, 4},
+                              {5, 6, INF}};
+    CostMatrix matrix(cost_matrix);
+
+    // Rows are padded to whole cache lines and the padding is INF
+    ASSERT_EQ(matrix.size(), 3u);
+    ASSERT_EQ(matrix.stride() * sizeof(cost_t) % CostMatrix::alignment, 0u);
+    for (std::size_t r = 0; r < matrix.size(); ++r)
+    {
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(matrix[r]) % CostMatrix::alignment, 0u);
+        for (std::size_t c = matrix.size(); c < matrix.stride(); ++c)
+        {
+            ASSERT_EQ(matrix[r][c], INF);
+        }
+    }
+    ASSERT_EQ(matrix.get_matrix(), cost_matrix);
+
+    // A copy owns its own buffer
+    CostMatrix copy(matrix);
+    copy[0][1] = INF;
+    ASSERT_EQ(matrix[0][1], 1);
+    ASSERT_EQ(copy[0][1], INF);
+}
+
+TEST(CostMatrixTest, incremental_reduction)
+{
+    cost_matrix_t cost_matrix{{INF, 10, 8, 19, 12},
+                              {10, INF, 20, 6, 3},
+                              {8, 20, INF, 4, 2},
+                              {19, 6, 4, INF, 7},
+                              {12, 3, 2, 7, INF}};
+    CostMatrix matrix(cost_matrix);
+    ASSERT_EQ(matrix.reduce_cols() + matrix.reduce_rows(), 28);
+
+    // A reduced matrix has nothing left to reduce
+    ASSERT_EQ(matrix.reduce_cols() + matrix.reduce_rows(), 0);
+
+    // Change cells the way branching does and compare with reducing a fresh copy
+    matrix.set(2, 4, INF);
+    matrix.set(4, 1, INF);
+    matrix.erase(0, 2);
+    CostMatrix fresh(matrix.get_matrix());
+
+    ASSERT_EQ(matrix.get_min_values_in_rows(), fresh.get_min_values_in_rows());
+    ASSERT_EQ(matrix.get_min_values_in_cols(), fresh.get_min_values_in_cols());
+    ASSERT_EQ(matrix.reduce_cols(), fresh.reduce_cols());
+    ASSERT_EQ(matrix.reduce_rows(), fresh.reduce_rows());
+    ASSERT_EQ(matrix.get_matrix(), fresh.get_matrix());
+    ASSERT_EQ(matrix.get_min_values_in_rows(), fresh.get_min_values_in_rows());
+    ASSERT_EQ(matrix.get_min_values_in_cols(), fresh.get_min_values_in_cols());
+}
+
+TEST(CostMatrixTest, get_two_smallest_values)
+{
+    std::vector<cost_t> v1{INF, 1, 0, 9, 4};
+    std::vector<cost_t> v2{1, INF, 17, 1, 0};
+    std::vector<cost_t> v3{0, 17, INF, 0, 0};
+    std::vector<cost_t> v4{9, 1, 0, INF, 3};
+    std::vector<cost_t> v5{4, 0, 0, 3, INF};
+    cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
+    CostMatrix matrix(cost_matrix);
+
+    line_minima_t minima;
+    matrix.get_two_smallest_values(minima);
+    ASSERT_EQ(minima.row_first, std::vector<cost_t>({0, 0, 0, 0, 0}));
+    ASSERT_EQ(minima.row_second, std::vector<cost_t>({1, 1, 0, 1, 0}));
+    ASSERT_EQ(minima.col_first, std::vector<cost_t>({0, 0, 0, 0, 0}));
+    ASSERT_EQ(minima.col_second, std::vector<cost_t>({1, 1, 0, 1, 0}));
+
+    // The O(1) cost of every zero agrees with get_vertex_cost
+    for (std::size_t r = 0; r < matrix.size(); ++r)
+    {
+        for (std::size_t c = 0; c < matrix.size(); ++c)
+        {
+            if (matrix[r][c] == 0)
+            {
+                ASSERT_EQ(minima.row_second[r] + minima.col_second[c], matrix.get_vertex_cost(r, c));
+            }
+        }
+    }
+}
+
+TEST(CostMatrixTest, pooled_buffers)
+{
+    cost_matrix_t cost_matrix{{INF, 10, 8, 19, 12},
+                              {10, INF, 20, 6, 3},
+                              {8, 20, INF, 4, 2},
+                              {19, 6, 4, INF, 7},
+                              {12, 3, 2, 7, INF}};
+    MatrixPool pool(cost_matrix.size());
+    {
+        CostMatrix matrix(cost_matrix, pool);
+        CostMatrix copy(matrix);
+        ASSERT_EQ(copy.get_pool(), &pool);
+        ASSERT_EQ(pool.in_use(), 2u);
+
+        // Erasing compacts the matrix within its buffer
+        copy.erase(0, 2);
+        CostMatrix fresh(copy.get_matrix());
+        ASSERT_EQ(copy.reduce_cols() + copy.reduce_rows(), fresh.reduce_cols() + fresh.reduce_rows());
+        ASSERT_EQ(copy.get_matrix(), fresh.get_matrix());
+        ASSERT_EQ(matrix.get_matrix(), cost_matrix);
+    }
+    ASSERT_EQ(pool.in_use(), 0u);
+    ASSERT_EQ(pool.high_water_mark(), 2u);
+
+    // Buffers given back are reused
+    {
+        CostMatrix a(cost_matrix, pool);
+        CostMatrix b(a);
+    }
+    ASSERT_EQ(pool.allocated(), 2u);
+
+    cost_matrix_t too_large(6, std::vector<cost_t>(6, 1));
+    ASSERT_THROW(CostMatrix(too_large, pool), std::invalid_argument);
+}
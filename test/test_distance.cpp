@@ -0,0 +1,42 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_distance.hpp"
+
+#include <random>
+#include <vector>
+
+TEST(DistanceTest, rounding)
+{
+    const point_t a{0.0, 0.0};
+    const point_t b{1.0, 1.0};
+    ASSERT_EQ(get_distance(a, b, rounding_t::Nearest), 1);
+    ASSERT_EQ(get_distance(a, b, rounding_t::Up), 2);
+    ASSERT_EQ(get_distance(a, point_t{3.0, 4.0}, rounding_t::Up), 5);
+}
+
+TEST(DistanceTest, rows_match_matrix)
+{
+    std::mt19937 rng(30);
+    std::vector<point_t> points(40);
+    for (point_t &p : points)
+    {
+        p.x = static_cast<double>(rng() % 1000);
+        p.y = static_cast<double>(rng() % 1000);
+    }
+    const PointDistances distances(points, rounding_t::Up, 4);
+    const cost_matrix_t matrix = distances.get_matrix();
+    ASSERT_EQ(matrix[3][3], INF);
+
+    // Visit the rows in an order which keeps evicting and reusing them.
+    for (std::size_t k = 0; k < 200; ++k)
+    {
+        const std::size_t from = (k * 7) % 11;
+        const cost_t *row = distances.row(from);
+        for (std::size_t to = 0; to < points.size(); ++to)
+        {
+            ASSERT_EQ(row[to], matrix[from][to]);
+            ASSERT_EQ(distances(from, to), matrix[from][to]);
+        }
+    }
+    ASSERT_LE(distances.memory_usage(), sizeof(PointDistances) + 40 * sizeof(point_t) + 4 * (40 * sizeof(cost_t) + 64));
+}
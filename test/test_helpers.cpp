@@ -0,0 +1,44 @@
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Build a random asymmetric matrix with costs in [1, range].
+ * @param n
+ * @param range
+ * @param rng
+ * @param forbidden_one_in If not 0, about one in that many transitions is forbidden.
+ */
+cost_matrix_t random_matrix(std::size_t n, cost_t range, std::mt19937 &rng, unsigned forbidden_one_in)
+{
+    cost_matrix_t cm(n, std::vector<cost_t>(n, INF));
+    for (std::size_t r = 0; r < n; ++r)
+    {
+        for (std::size_t c = 0; c < n; ++c)
+        {
+            if (r != c && (forbidden_one_in == 0 || rng() % forbidden_one_in != 0))
+            {
+                cm[r][c] = static_cast<cost_t>(rng() % static_cast<unsigned>(range)) + 1;
+            }
+        }
+    }
+    return cm;
+}
+
+/**
+ * Check that the path visits every city once, starting at city 1.
+ */
+bool is_tour(const path_t &path, std::size_t n)
+{
+    path_t sorted(path);
+    std::sort(sorted.begin(), sorted.end());
+    for (std::size_t k = 0; k < n; ++k)
+    {
+        if (sorted.size() != n || sorted[k] != k + 1)
+        {
+            return false;
+        }
+    }
+    return path.front() == 1;
+}
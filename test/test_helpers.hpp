@@ -0,0 +1,16 @@
+//
+// Helpers shared by the tests.
+//
+
+#ifndef IMPLEMENTATION_TEST_HELPERS_HPP
+#define IMPLEMENTATION_TEST_HELPERS_HPP
+
+#include "TSP.hpp"
+
+#include <cstddef>
+#include <random>
+
+cost_matrix_t random_matrix(std::size_t n, cost_t range, std::mt19937& rng, unsigned forbidden_one_in = 0);
+bool is_tour(const path_t& path, std::size_t n);
+
+#endif //IMPLEMENTATION_TEST_HELPERS_HPP
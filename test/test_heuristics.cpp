@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_heuristics.hpp"
+#include "test_helpers.hpp"
+
+#include <random>
+#include <vector>
+
+TEST(HeuristicsTest, construction_gives_tours)
+{
+    std::mt19937 rng(10);
+    for (std::size_t n = 2; n < 12; ++n)
+    {
+        cost_matrix_t cm = random_matrix(n, 1000, rng);
+        ASSERT_TRUE(is_tour(get_nearest_neighbour_path(cm), n));
+        ASSERT_TRUE(is_tour(get_nearest_neighbour_path(cm, n - 1), n));
+        ASSERT_TRUE(is_tour(get_greedy_edge_path(cm), n));
+    }
+}
+
+TEST(HeuristicsTest, local_search_improves)
+{
+    std::mt19937 rng(11);
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        cost_matrix_t cm = random_matrix(15, 1000, rng);
+        path_t path = get_nearest_neighbour_path(cm);
+        cost_t cost = get_optimal_cost(path, cm);
+
+        // Every applied move lowers the cost and keeps a tour
+        while (improve_two_opt(cm, path) || improve_or_opt(cm, path))
+        {
+            ASSERT_TRUE(is_tour(path, cm.size()));
+            const cost_t new_cost = get_optimal_cost(path, cm);
+            ASSERT_LT(new_cost, cost);
+            cost = new_cost;
+        }
+    }
+}
+
+TEST(HeuristicsTest, warm_start)
+{
+    std::mt19937 rng(12);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm = random_matrix(10, 1000, rng);
+        tsp_solution_t heuristic = get_heuristic_solution(cm);
+        ASSERT_EQ(heuristic.lower_bound, get_optimal_cost(heuristic.path, cm));
+
+        // The warm start only prunes, so the same optimal tours are found
+        tsp_options_t cold;
+        cold.engine = tsp_engine_t::BranchAndBound;
+        cold.warm_start = false;
+        tsp_solutions_t expected = solve_tsp(cm, cold);
+
+        warm_start_report_t report;
+        tsp_options_t warm;
+        warm.engine = tsp_engine_t::BranchAndBound;
+        warm.warm_start_report = &report;
+        tsp_solutions_t solutions = solve_tsp(cm, warm);
+
+        ASSERT_EQ(solutions.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(solutions[i].path, expected[i].path);
+        }
+        ASSERT_EQ(report.heuristic_cost, heuristic.lower_bound);
+        ASSERT_EQ(report.optimal_cost, expected.front().lower_bound);
+        ASSERT_GE(report.gap(), 0.0);
+    }
+}
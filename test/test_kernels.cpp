@@ -0,0 +1,124 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_kernels.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+TEST(KernelsTest, levels_agree)
+{
+    const simd_level_t supported = get_supported_simd_level();
+    std::mt19937 rng(5);
+
+    // Odd sizes exercise the scalar tails of the vector loops
+    for (std::size_t n : {1u, 3u, 4u, 7u, 8u, 9u, 17u, 33u})
+    {
+        const cost_matrix_t m = random_matrix(n, 1000, rng, 5);
+
+        std::vector<cost_matrix_t> reduced;
+        std::vector<cost_t> lower_bounds;
+        std::vector<line_minima_t> minima(3);
+        for (simd_level_t level : {simd_level_t::Scalar, simd_level_t::SSE41, simd_level_t::AVX2})
+        {
+            if (level > supported)
+            {
+                break;
+            }
+            set_simd_level(level);
+            CostMatrix matrix(m);
+            lower_bounds.push_back(matrix.reduce_cols() + matrix.reduce_rows());
+            matrix.get_two_smallest_values(minima[reduced.size()]);
+            reduced.push_back(matrix.get_matrix());
+        }
+        set_simd_level(supported);
+
+        for (std::size_t i = 1; i < reduced.size(); ++i)
+        {
+            ASSERT_EQ(lower_bounds[i], lower_bounds[0]);
+            ASSERT_EQ(reduced[i], reduced[0]);
+            ASSERT_EQ(minima[i].row_first, minima[0].row_first);
+            ASSERT_EQ(minima[i].row_second, minima[0].row_second);
+            ASSERT_EQ(minima[i].col_first, minima[0].col_first);
+            ASSERT_EQ(minima[i].col_second, minima[0].col_second);
+        }
+    }
+}
+
+TEST(KernelsTest, vector_levels_follow_cost_type)
+{
+    const simd_level_t supported = get_supported_simd_level();
+    if (!std::is_same<cost_t, std::int32_t>::value)
+    {
+        ASSERT_EQ(supported, simd_level_t::Scalar);
+        return;
+    }
+#if defined(__x86_64__) || defined(__i386__)
+    // 32-bit integer costs use the vector kernels, whichever macro selected them
+    if (__builtin_cpu_supports("sse4.1"))
+    {
+        ASSERT_NE(supported, simd_level_t::Scalar);
+    }
+#endif
+}
+
+TEST(KernelsTest, row_subtract_keeps_inf)
+{
+    std::vector<cost_t> row{5, INF, 7, 9, INF, 6, 8, 5, 11, INF};
+    std::vector<cost_t> col_min(row.size(), INF);
+
+    const cost_kernels_t &kernels = get_cost_kernels();
+    ASSERT_EQ(kernels.row_min(row.data(), row.size()), 5);
+    kernels.row_subtract(row.data(), row.size(), 5, col_min.data());
+
+    std::vector<cost_t> expected{0, INF, 2, 4, INF, 1, 3, 0, 6, INF};
+    ASSERT_EQ(row, expected);
+    ASSERT_EQ(col_min, expected);
+}
+
+TEST(KernelsTest, min_plus)
+{
+    const simd_level_t supported = get_supported_simd_level();
+    std::mt19937 rng(6);
+    // Sums of the last value reach INF
+    const std::vector<cost_t> values{0, 7, 500, INF - 3};
+    for (std::size_t n : {1u, 5u, 8u, 13u})
+    {
+        std::vector<std::vector<cost_t>> others(values.size(), std::vector<cost_t>(n));
+        std::vector<const cost_t *> pointers;
+        for (auto &other : others)
+        {
+            for (cost_t &cell : other)
+            {
+                cell = (rng() % 4 == 0) ? INF : static_cast<cost_t>(rng() % 1000);
+            }
+            pointers.push_back(other.data());
+        }
+        for (std::size_t n_values = 0; n_values <= values.size(); ++n_values)
+        {
+            std::vector<cost_t> expected(n, INF);
+            for (std::size_t i = 0; i < n; ++i)
+            {
+                for (std::size_t k = 0; k < n_values; ++k)
+                {
+                    expected[i] = std::min(expected[i], add_costs(values[k], others[k][i]));
+                }
+            }
+            for (simd_level_t level : {simd_level_t::Scalar, simd_level_t::SSE41, simd_level_t::AVX2})
+            {
+                if (level > supported)
+                {
+                    break;
+                }
+                set_simd_level(level);
+                std::vector<cost_t> result(n, 0);
+                get_cost_kernels().min_plus(result.data(), n, values.data(), pointers.data(), n_values);
+                ASSERT_EQ(result, expected);
+            }
+            set_simd_level(supported);
+        }
+    }
+}
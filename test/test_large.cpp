@@ -0,0 +1,111 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_large.hpp"
+#include "test_helpers.hpp"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+/**
+ * The cost of a tour through points, with rounded Euclidean distances (INF if
+ * it does not fit into cost_t).
+ */
+static cost_t points_cost(const std::vector<point_t> &points, const path_t &path)
+{
+    cost_sum_t cost = 0;
+    for (std::size_t k = 0; k < path.size(); ++k)
+    {
+        const point_t &a = points[path[k] - 1];
+        const point_t &b = points[path[(k + 1) % path.size()] - 1];
+        cost += static_cast<cost_sum_t>(std::lround(std::hypot(a.x - b.x, a.y - b.y)));
+    }
+    return cost >= static_cast<cost_sum_t>(INF) ? INF : static_cast<cost_t>(cost);
+}
+
+TEST(LargeTest, small_matrices)
+{
+    std::mt19937 rng(20);
+    large_tsp_options_t options;
+    options.max_kicks = 100;
+    options.time_limit = 60;
+    for (std::size_t n = 2; n < 12; ++n)
+    {
+        for (bool symmetric : {false, true})
+        {
+            cost_matrix_t cm(n, std::vector<cost_t>(n, INF));
+            for (std::size_t r = 0; r < n; ++r)
+            {
+                for (std::size_t c = 0; c < n; ++c)
+                {
+                    if (r != c)
+                    {
+                        cm[r][c] = (symmetric && c < r) ? cm[c][r] : static_cast<cost_t>(rng() % 100);
+                    }
+                }
+            }
+            tsp_solution_t solution = solve_tsp_large(cm, options);
+
+            ASSERT_TRUE(is_tour(solution.path, n));
+            ASSERT_EQ(solution.lower_bound, get_optimal_cost(solution.path, cm));
+            ASSERT_GE(solution.lower_bound, solve_tsp(cm).front().lower_bound);
+        }
+    }
+}
+
+TEST(LargeTest, random_points)
+{
+    std::mt19937 rng(21);
+    const std::size_t n = 2000;
+    std::vector<point_t> points(n);
+    for (point_t &p : points)
+    {
+        p.x = static_cast<double>(rng() % 100000);
+        p.y = static_cast<double>(rng() % 100000);
+    }
+    large_tsp_options_t options;
+    options.max_kicks = 2000;
+    options.time_limit = 60;
+    tsp_solution_t solution = solve_tsp_large(points, options);
+
+    ASSERT_TRUE(is_tour(solution.path, n));
+    ASSERT_EQ(solution.lower_bound, points_cost(points, solution.path));
+    // The optimal tour through n random points in a square of side a has
+    // about 0.7124 * a * sqrt(n) (a bit more, near the border).
+    ASSERT_LT(solution.lower_bound, 1.1 * 0.7124 * 100000 * std::sqrt(static_cast<double>(n)));
+}
+
+TEST(LargeTest, degenerate_points)
+{
+    std::vector<point_t> points(50, point_t{3.0, 4.0});
+    points[10] = {3.0, 10.0};
+    large_tsp_options_t options;
+    options.max_kicks = 10;
+    tsp_solution_t solution = solve_tsp_large(points, options);
+
+    ASSERT_TRUE(is_tour(solution.path, points.size()));
+    ASSERT_EQ(solution.lower_bound, 12);
+}
+
+TEST(LargeTest, tour_costs_saturate)
+{
+    // 10 cities on a circle, about 5560 apart: the tour costs more than INF with 16-bit costs
+    std::vector<point_t> points;
+    for (int k = 0; k < 10; ++k)
+    {
+        const double angle = 2 * M_PI * k / 10;
+        points.push_back({9000 * std::cos(angle), 9000 * std::sin(angle)});
+    }
+    const cost_matrix_t cm = PointDistances(points).get_matrix();
+    large_tsp_options_t options;
+    options.max_kicks = 10;
+
+    tsp_solution_t solution = solve_tsp_large(cm, options);
+    ASSERT_TRUE(is_tour(solution.path, points.size()));
+    ASSERT_EQ(solution.lower_bound, get_optimal_cost(solution.path, cm));
+
+    solution = solve_tsp_large(points, options);
+    ASSERT_TRUE(is_tour(solution.path, points.size()));
+    ASSERT_EQ(solution.lower_bound, get_optimal_cost(solution.path, cm));
+    ASSERT_EQ(solution.lower_bound, points_cost(points, solution.path));
+}
@@ -1,5 +1,16 @@
 #include "gtest/gtest.h"
 #include "TSP.hpp"
+#include "tsp_distance.hpp"
+#include "tsp_pool.hpp"
+#include "test_helpers.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <utility>
 
 TEST(Solution, test1)
 {
@@ -31,4 +42,619 @@ TEST(Solution, test2)
     ASSERT_EQ(solutions[0].lower_bound, 30);
     ASSERT_EQ(solutions[0].path, solution);
     std::cout << "Tests passed 2!" << std::endl;
-}
\ No newline at end of file
+}
+/**
+ * Find the optimal cost by checking every tour starting in the first city.
+ */
+static cost_t brute_force_cost(const cost_matrix_t &cm)
+{
+    path_t p(cm.size());
+    std::iota(p.begin(), p.end(), 1);
+    cost_t best = INF;
+    do
+    {
+        best = std::min(best, get_optimal_cost(p, cm));
+    } while (std::next_permutation(p.begin() + 1, p.end()));
+    return best;
+}
+
+/**
+ * The settings which make solve_tsp() search the tree whatever the size,
+ * for the tests of the branch & bound engines.
+ */
+static tsp_options_t branch_and_bound()
+{
+    tsp_options_t options;
+    options.engine = tsp_engine_t::BranchAndBound;
+    return options;
+}
+
+TEST(Solution, random_against_brute_force)
+{
+    std::mt19937 rng(2020);
+    for (int trial = 0; trial < 20; ++trial)
+    {
+        const std::size_t n = 4 + static_cast<std::size_t>(trial % 5);
+        cost_matrix_t cm = random_matrix(n, 10, rng);
+
+        tsp_solutions_t solutions = solve_tsp(cm);
+        ASSERT_FALSE(solutions.empty());
+        const cost_t optimal = brute_force_cost(cm);
+        for (const auto &s : solutions)
+        {
+            ASSERT_EQ(s.lower_bound, optimal);
+            ASSERT_EQ(get_optimal_cost(s.path, cm), optimal);
+        }
+    }
+}
+
+TEST(Solution, parallel_matches_sequential)
+{
+    std::mt19937 rng(6);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        // A small cost range gives many optimal tours, so the order matters too
+        cost_matrix_t cm = random_matrix(9, 4, rng);
+
+        tsp_solutions_t sequential = solve_tsp(cm, branch_and_bound());
+        tsp_options_t options = branch_and_bound();
+        options.n_threads = 4;
+        tsp_solutions_t parallel = solve_tsp(cm, options);
+
+        ASSERT_EQ(parallel.size(), sequential.size());
+        for (std::size_t i = 0; i < sequential.size(); ++i)
+        {
+            ASSERT_EQ(parallel[i].lower_bound, sequential[i].lower_bound);
+            ASSERT_EQ(parallel[i].path, sequential[i].path);
+        }
+    }
+}
+
+TEST(Solution, strategies_match_depth_first)
+{
+    std::mt19937 rng(7);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm = random_matrix(9, 4, rng);
+        tsp_solutions_t depth_first = solve_tsp(cm, branch_and_bound());
+
+        // The last setting leaves no room in the open list, so everything is searched depth first.
+        for (auto setting : {std::make_pair(search_strategy_t::BestFirst, std::size_t(0)),
+                             std::make_pair(search_strategy_t::Hybrid, std::size_t(0)),
+                             std::make_pair(search_strategy_t::BestFirst, std::size_t(20000)),
+                             std::make_pair(search_strategy_t::Hybrid, std::size_t(1))})
+        {
+            tsp_options_t options = branch_and_bound();
+            options.strategy = setting.first;
+            options.max_open_bytes = setting.second;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            ASSERT_EQ(solutions.size(), depth_first.size());
+            for (std::size_t i = 0; i < depth_first.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].lower_bound, depth_first[i].lower_bound);
+                ASSERT_EQ(solutions[i].path, depth_first[i].path);
+            }
+        }
+    }
+}
+
+TEST(Solution, reuses_pool)
+{
+    std::mt19937 rng(8);
+    cost_matrix_t cm = random_matrix(10, 100, rng);
+    MatrixPool pool(cm.size());
+
+    tsp_solutions_t solutions = solve_tsp(cm, branch_and_bound(), pool);
+    ASSERT_EQ(solutions.front().lower_bound, brute_force_cost(cm));
+    ASSERT_EQ(pool.in_use(), 0u);
+    ASSERT_GT(pool.high_water_mark(), 0u);
+
+    // A second search of the same size needs no new buffers
+    const std::size_t allocated = pool.allocated();
+    solve_tsp(cm, branch_and_bound(), pool);
+    ASSERT_EQ(pool.allocated(), allocated);
+}
+
+TEST(Solution, undo_trail_matches_copying)
+{
+    std::mt19937 rng(9);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        cost_matrix_t cm = random_matrix(9, 4, rng);
+
+        tsp_solutions_t copying = solve_tsp(cm, branch_and_bound());
+        tsp_options_t options = branch_and_bound();
+        options.undo_trail = true;
+        tsp_solutions_t trail = solve_tsp(cm, options);
+
+        ASSERT_EQ(trail.size(), copying.size());
+        for (std::size_t i = 0; i < copying.size(); ++i)
+        {
+            ASSERT_EQ(trail[i].lower_bound, copying[i].lower_bound);
+            ASSERT_EQ(trail[i].path, copying[i].path);
+        }
+    }
+}
+
+TEST(Solution, collects_stats)
+{
+#ifdef TSP_NO_STATS
+    GTEST_SKIP() << "built without the statistics";
+#endif
+    std::mt19937 rng(10);
+    cost_matrix_t cm = random_matrix(10, 100, rng);
+    tsp_solutions_t expected = solve_tsp(cm, branch_and_bound());
+
+    tsp_options_t depth_first = branch_and_bound();
+    tsp_options_t trail = branch_and_bound();
+    trail.undo_trail = true;
+    tsp_options_t best_first = branch_and_bound();
+    best_first.strategy = search_strategy_t::BestFirst;
+    tsp_options_t parallel = branch_and_bound();
+    parallel.n_threads = 2;
+    for (tsp_options_t options : {depth_first, trail, best_first, parallel})
+    {
+        for (bool warm_start : {true, false})
+        {
+            search_stats_t stats;
+            options.stats = &stats;
+            options.warm_start = warm_start;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            // Collecting the statistics does not change the search
+            ASSERT_EQ(solutions.size(), expected.size());
+            ASSERT_EQ(solutions.front().path, expected.front().path);
+
+            ASSERT_GT(stats.nodes_expanded, 0u);
+            ASSERT_GT(stats.max_depth, 0u);
+            ASSERT_GT(stats.reduction_seconds, 0.0);
+            ASSERT_FALSE(stats.incumbents.empty());
+            ASSERT_EQ(stats.incumbents.back().cost, expected.front().lower_bound);
+            for (std::size_t i = 1; i < stats.incumbents.size(); ++i)
+            {
+                ASSERT_LT(stats.incumbents[i].cost, stats.incumbents[i - 1].cost);
+                ASSERT_GE(stats.incumbents[i].seconds, 0.0);
+            }
+        }
+    }
+}
+
+TEST(Solution, stops_at_limits)
+{
+    std::mt19937 rng(11);
+    cost_matrix_t cm = random_matrix(25, 1000, rng);
+    search_outcome_t full;
+    tsp_options_t unlimited;
+    unlimited.outcome = &full;
+    const cost_t optimal = solve_tsp(cm, unlimited).front().lower_bound;
+    ASSERT_TRUE(full.complete);
+    ASSERT_EQ(full.lower_bound, optimal);
+    ASSERT_EQ(full.gap(), 0.0);
+
+    CancellationToken cancelled;
+    cancelled.cancel();
+
+    tsp_options_t depth_first;
+    tsp_options_t trail;
+    trail.undo_trail = true;
+    tsp_options_t best_first;
+    best_first.strategy = search_strategy_t::BestFirst;
+    tsp_options_t parallel;
+    parallel.n_threads = 2;
+    for (tsp_options_t options : {depth_first, trail, best_first, parallel})
+    {
+        for (int limit = 0; limit < 3; ++limit)
+        {
+            tsp_options_t limited = options;
+            limited.node_limit = (limit == 0) ? 5 : 0;
+            limited.time_limit = (limit == 1) ? 1e-6 : 0;
+            limited.cancel = (limit == 2) ? &cancelled : nullptr;
+            search_outcome_t outcome;
+            limited.outcome = &outcome;
+            tsp_solutions_t solutions = solve_tsp(cm, limited);
+
+            // The best tour found so far (at least the one of the warm start) and a valid bound
+            ASSERT_FALSE(outcome.complete);
+            ASSERT_FALSE(solutions.empty());
+            ASSERT_EQ(get_optimal_cost(solutions.front().path, cm), outcome.best_cost);
+            ASSERT_LE(outcome.lower_bound, optimal);
+            ASSERT_GE(outcome.best_cost, optimal);
+            ASSERT_GE(outcome.gap(), 0.0);
+        }
+    }
+}
+
+TEST(Solution, held_karp_matches_branch_and_bound)
+{
+    std::mt19937 rng(13);
+    auto by_path = [](const tsp_solution_t &a, const tsp_solution_t &b) { return a.path < b.path; };
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        // A small cost range gives many optimal tours, and some transitions are forbidden
+        cost_matrix_t cm = random_matrix(6 + static_cast<std::size_t>(trial % 7), 4, rng);
+        cm[1][2] = INF;
+        cm[3][0] = INF;
+        tsp_solutions_t expected = solve_tsp(cm, branch_and_bound());
+        std::sort(expected.begin(), expected.end(), by_path);
+
+        tsp_solutions_t first;
+        for (std::size_t n_threads : {1, 3})
+        {
+            tsp_options_t options;
+            options.engine = tsp_engine_t::HeldKarp;
+            options.n_threads = n_threads;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            // The order does not depend on the threads
+            if (first.empty())
+            {
+                first = solutions;
+            }
+            ASSERT_EQ(solutions.size(), first.size());
+            for (std::size_t i = 0; i < first.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].path, first[i].path);
+            }
+
+            std::sort(solutions.begin(), solutions.end(), by_path);
+            ASSERT_EQ(solutions.size(), expected.size());
+            for (std::size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].lower_bound, expected[i].lower_bound);
+                ASSERT_EQ(solutions[i].path, expected[i].path);
+            }
+        }
+    }
+
+    // Small instances go to the Held-Karp engine unless it would take too much memory
+    cost_matrix_t cm = random_matrix(12, 100, rng);
+    search_stats_t stats;
+    tsp_options_t options;
+    options.stats = &stats;
+    solve_tsp(cm, options);
+#ifndef TSP_NO_STATS
+    ASSERT_EQ(stats.nodes_expanded, (std::size_t(1) << 11) - 1);
+#endif
+    options.held_karp_max_bytes = get_held_karp_bytes(cm.size()) - 1;
+    solve_tsp(cm, options);
+#ifndef TSP_NO_STATS
+    ASSERT_GT(stats.max_depth, 0u);
+#endif
+}
+
+TEST(Solution, tour_costs_saturate)
+{
+    // 10 cities on a circle, about 5560 apart: the tours cost more than INF with 16-bit costs
+    std::vector<point_t> points;
+    for (int k = 0; k < 10; ++k)
+    {
+        const double angle = 2 * M_PI * k / 10;
+        points.push_back({9000 * std::cos(angle), 9000 * std::sin(angle)});
+    }
+    const cost_matrix_t cm = PointDistances(points).get_matrix();
+    path_t circle(cm.size());
+    std::iota(circle.begin(), circle.end(), 1);
+    cost_sum_t circle_cost = 0;
+    for (std::size_t k = 0; k < circle.size(); ++k)
+    {
+        circle_cost += cm[k][(k + 1) % cm.size()];
+    }
+    const bool fits = circle_cost < static_cast<cost_sum_t>(INF);
+    ASSERT_EQ(get_optimal_cost(circle, cm), fits ? static_cast<cost_t>(circle_cost) : INF);
+
+    for (tsp_engine_t engine : {tsp_engine_t::BranchAndBound, tsp_engine_t::HeldKarp})
+    {
+        for (std::size_t node_limit : {0, 1})
+        {
+            tsp_options_t options;
+            options.engine = engine;
+            options.node_limit = node_limit;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+
+            // Either the circle (or a tour as cheap), or nothing if no tour cost fits into cost_t
+            if (!fits)
+            {
+                ASSERT_TRUE(solutions.empty());
+                continue;
+            }
+            ASSERT_FALSE(solutions.empty());
+            for (const tsp_solution_t &s : solutions)
+            {
+                ASSERT_GE(s.lower_bound, 0);
+                ASSERT_EQ(s.lower_bound, get_optimal_cost(s.path, cm));
+                if (node_limit == 0)
+                {
+                    ASSERT_EQ(s.lower_bound, static_cast<cost_t>(circle_cost));
+                }
+            }
+        }
+    }
+}
+
+TEST(Solution, fractional_costs)
+{
+    // The same tour summed in another order may cost a few ULPs more with floating-point costs
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<double> uniform(1, 100);
+    tsp_options_t depth_first = branch_and_bound();
+    tsp_options_t trail = branch_and_bound();
+    trail.undo_trail = true;
+    tsp_options_t best_first = branch_and_bound();
+    best_first.strategy = search_strategy_t::BestFirst;
+    tsp_options_t parallel = branch_and_bound();
+    parallel.n_threads = 2;
+    tsp_options_t held_karp;
+    held_karp.engine = tsp_engine_t::HeldKarp;
+
+    for (int trial = 0; trial < 200; ++trial)
+    {
+        const std::size_t n = 7;
+        cost_matrix_t cm(n, std::vector<cost_t>(n, INF));
+        for (std::size_t r = 0; r < n; ++r)
+        {
+            for (std::size_t c = r + 1; c < n; ++c)
+            {
+                cm[r][c] = cm[c][r] = static_cast<cost_t>(uniform(rng));
+            }
+        }
+        const double optimal = static_cast<double>(solve_tsp(cm, held_karp).front().lower_bound);
+
+        for (const tsp_options_t &options : {depth_first, trail, best_first, parallel})
+        {
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+            ASSERT_FALSE(solutions.empty());
+            for (const tsp_solution_t &s : solutions)
+            {
+                ASSERT_TRUE(is_tour(s.path, n));
+                ASSERT_NEAR(static_cast<double>(s.lower_bound), optimal, 1e-5 * optimal);
+            }
+        }
+    }
+}
+
+TEST(Solution, held_karp_stops_at_limits)
+{
+    std::mt19937 rng(14);
+    cost_matrix_t cm = random_matrix(14, 1000, rng);
+    const cost_t optimal = solve_tsp(cm).front().lower_bound;
+
+    tsp_options_t options;
+    options.engine = tsp_engine_t::HeldKarp;
+    options.node_limit = 100;
+    search_outcome_t outcome;
+    options.outcome = &outcome;
+    tsp_solutions_t solutions = solve_tsp(cm, options);
+
+    // The tour of the warm start and the bound of the reduced matrix
+    ASSERT_FALSE(outcome.complete);
+    ASSERT_FALSE(solutions.empty());
+    ASSERT_EQ(get_optimal_cost(solutions.front().path, cm), outcome.best_cost);
+    ASSERT_LE(outcome.lower_bound, optimal);
+    ASSERT_GE(outcome.best_cost, optimal);
+}
+
+TEST(Solution, held_karp_reuses_table)
+{
+    std::mt19937 rng(17);
+    tsp_options_t options;
+    options.engine = tsp_engine_t::HeldKarp;
+    std::vector<cost_t> table;
+    options.held_karp_table = &table;
+
+    cost_matrix_t cm = random_matrix(10, 100, rng);
+    ASSERT_EQ(solve_tsp(cm, options).front().lower_bound, brute_force_cost(cm));
+    ASSERT_EQ(table.size(), (std::size_t(1) << 9) * 10);
+
+    // Solves of no more cities take the same table, whatever was left in it
+    const cost_t *data = table.data();
+    for (std::size_t n : {10, 6, 9})
+    {
+        cm = random_matrix(n, 100, rng);
+        ASSERT_EQ(solve_tsp(cm, options).front().lower_bound, brute_force_cost(cm));
+        ASSERT_EQ(table.data(), data);
+    }
+}
+
+TEST(Solution, resolve_matches_solve)
+{
+    std::mt19937 rng(15);
+    for (int trial = 0; trial < 10; ++trial)
+    {
+        // Both engines: Held-Karp for the smaller instances
+        const std::size_t n = (trial % 2 == 0) ? 14 : 9;
+        cost_matrix_t cm = random_matrix(n, 100, rng);
+        const tsp_solutions_t previous = solve_tsp(cm);
+        const path_t &tour = previous.front().path;
+
+        // Make a transition of the optimal tour dearer, forbid another, and change some other cells
+        std::vector<cost_change_t> changes;
+        changes.push_back({tour[0] - 1, tour[1] - 1, static_cast<cost_t>(cm[tour[0] - 1][tour[1] - 1] + 50)});
+        changes.push_back({tour[2] - 1, tour[3] - 1, INF});
+        for (int k = 0; k < 4; ++k)
+        {
+            const std::size_t row = rng() % n;
+            const std::size_t col = (row + 1 + rng() % (n - 1)) % n;
+            changes.push_back({row, col, static_cast<cost_t>(rng() % 100 + 1)});
+        }
+
+        cost_matrix_t changed = cm;
+        tsp_options_t options;
+        warm_start_report_t report;
+        options.warm_start_report = &report;
+        tsp_solutions_t solutions = resolve_tsp(changed, changes, previous, options);
+        for (const cost_change_t &change : changes)
+        {
+            cm[change.row][change.col] = change.cost;
+        }
+        ASSERT_EQ(changed, cm);
+
+        tsp_solutions_t expected = solve_tsp(cm);
+        ASSERT_EQ(solutions.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(solutions[i].lower_bound, expected[i].lower_bound);
+            ASSERT_EQ(solutions[i].path, expected[i].path);
+        }
+        ASSERT_EQ(report.optimal_cost, expected.front().lower_bound);
+    }
+
+    cost_matrix_t cm = random_matrix(5, 10, rng);
+    const cost_matrix_t original = cm;
+    ASSERT_THROW(resolve_tsp(cm, {{0, 1, 100}, {5, 0, 1}}, {}), std::out_of_range);
+    ASSERT_THROW(resolve_tsp(cm, {{0, 1, 100}, {0, 5, 1}}, {}), std::out_of_range);
+    ASSERT_EQ(cm, original);
+}
+
+TEST(Solution, batch_matches_single_solves)
+{
+    std::mt19937 rng(12);
+    std::vector<cost_matrix_t> matrices;
+    for (int i = 0; i < 40; ++i)
+    {
+        matrices.push_back(random_matrix(3 + static_cast<std::size_t>(i % 10), 10, rng));
+    }
+
+    for (std::size_t n_threads : {1, 3})
+    {
+        tsp_options_t options;
+        options.n_threads = n_threads;
+        search_stats_t stats;
+        options.stats = &stats;
+        std::vector<tsp_solutions_t> results = solve_tsp_batch(matrices, options);
+
+        ASSERT_EQ(results.size(), matrices.size());
+        for (std::size_t i = 0; i < matrices.size(); ++i)
+        {
+            tsp_solutions_t expected = solve_tsp(matrices[i]);
+            ASSERT_EQ(results[i].size(), expected.size());
+            for (std::size_t k = 0; k < expected.size(); ++k)
+            {
+                ASSERT_EQ(results[i][k].lower_bound, expected[k].lower_bound);
+                ASSERT_EQ(results[i][k].path, expected[k].path);
+            }
+        }
+#ifndef TSP_NO_STATS
+        ASSERT_GT(stats.nodes_expanded, 0u);
+#endif
+    }
+}
+
+TEST(Solution, keeps_tours_as_asked)
+{
+    std::mt19937 rng(16);
+    auto by_path = [](const tsp_solution_t &a, const tsp_solution_t &b) { return a.path < b.path; };
+    auto symmetric_matrix = [&rng](std::size_t n, cost_t range)
+    {
+        cost_matrix_t cm = random_matrix(n, range, rng);
+        for (std::size_t r = 0; r < cm.size(); ++r)
+        {
+            for (std::size_t c = 0; c < r; ++c)
+            {
+                cm[r][c] = cm[c][r];
+            }
+        }
+        return cm;
+    };
+
+    std::vector<tsp_options_t> engines(5, branch_and_bound());
+    engines[1].undo_trail = true;
+    engines[2].strategy = search_strategy_t::BestFirst;
+    engines[3].n_threads = 3;
+    engines[4].engine = tsp_engine_t::HeldKarp;
+
+    for (int trial = 0; trial < 6; ++trial)
+    {
+        // A small cost range gives many optimal tours
+        cost_matrix_t cm = symmetric_matrix(9, 4);
+        ASSERT_TRUE(is_symmetric(cm));
+        const tsp_solutions_t all = solve_tsp(cm, branch_and_bound());
+        const cost_t optimal = all.front().lower_bound;
+        tsp_solutions_t all_by_path = all;
+        std::sort(all_by_path.begin(), all_by_path.end(), by_path);
+        tsp_solutions_t tree_direction;
+
+        for (std::size_t engine = 0; engine < engines.size(); ++engine)
+        {
+            // The first tours found; the depth-first engines find them in the order of all of them
+            tsp_options_t options = engines[engine];
+            options.max_tours = 3;
+            tsp_solutions_t solutions = solve_tsp(cm, options);
+            ASSERT_EQ(solutions.size(), std::min<std::size_t>(3, all.size()));
+            for (std::size_t i = 0; i < solutions.size(); ++i)
+            {
+                ASSERT_EQ(solutions[i].lower_bound, optimal);
+                if (engine < 2)
+                {
+                    ASSERT_EQ(solutions[i].path, all[i].path);
+                }
+            }
+
+            // Every cycle once, streamed as found; the tree searches keep the same direction
+            options = engines[engine];
+            options.skip_reversed_tours = true;
+            tsp_solutions_t streamed;
+            options.on_tour = [&streamed](const tsp_solution_t &s) { streamed.push_back(s); };
+            solutions = solve_tsp(cm, options);
+            if (options.engine == tsp_engine_t::HeldKarp)
+            {
+                for (const tsp_solution_t &s : solutions)
+                {
+                    ASSERT_LT(s.path[1], s.path.back());
+                }
+            }
+            else
+            {
+                if (tree_direction.empty())
+                {
+                    tree_direction = solutions;
+                }
+                ASSERT_EQ(solutions.size(), tree_direction.size());
+                for (std::size_t i = 0; i < solutions.size(); ++i)
+                {
+                    ASSERT_EQ(solutions[i].path, tree_direction[i].path);
+                }
+            }
+            tsp_solutions_t both_directions = solutions;
+            for (const tsp_solution_t &s : solutions)
+            {
+                path_t reversed = s.path;
+                std::reverse(reversed.begin() + 1, reversed.end());
+                both_directions.push_back({s.lower_bound, reversed});
+            }
+            std::sort(both_directions.begin(), both_directions.end(), by_path);
+            ASSERT_EQ(both_directions.size(), all_by_path.size());
+            for (std::size_t i = 0; i < all_by_path.size(); ++i)
+            {
+                ASSERT_EQ(both_directions[i].path, all_by_path[i].path);
+            }
+
+            ASSERT_GE(streamed.size(), solutions.size());
+            for (std::size_t i = 1; i < streamed.size(); ++i)
+            {
+                ASSERT_LE(streamed[i].lower_bound, streamed[i - 1].lower_bound);
+            }
+            ASSERT_EQ(streamed.back().lower_bound, optimal);
+        }
+    }
+
+#ifndef TSP_NO_STATS
+    // The tree search does not visit the reverse tours
+    cost_matrix_t cm = symmetric_matrix(14, 100);
+    search_stats_t both_stats;
+    tsp_options_t options = branch_and_bound();
+    options.stats = &both_stats;
+    solve_tsp(cm, options);
+    search_stats_t one_stats;
+    options.stats = &one_stats;
+    options.skip_reversed_tours = true;
+    solve_tsp(cm, options);
+    ASSERT_LT(one_stats.nodes_expanded, both_stats.nodes_expanded);
+#endif
+
+    // Both directions of an asymmetric matrix are different tours
+    cost_matrix_t asymmetric = random_matrix(8, 4, rng);
+    tsp_options_t one_direction;
+    one_direction.skip_reversed_tours = true;
+    ASSERT_EQ(solve_tsp(asymmetric, one_direction).size(), solve_tsp(asymmetric).size());
+}
@@ -1,15 +1,16 @@
 #include "gtest/gtest.h"
 #include "TSP.hpp"
 #include <vector>
+#include <algorithm>
 
 TEST(StageStateTest, reduce_cost_matrix)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, 10, 8, 19, 12};
-    std::vector<int> v2{10, INF, 20, 6, 3};
-    std::vector<int> v3{8, 20, INF, 4, 2};
-    std::vector<int> v4{19, 6, 4, INF, 7};
-    std::vector<int> v5{12, 3, 2, 7, INF};
+    std::vector<cost_t> v1{INF, 10, 8, 19, 12};
+    std::vector<cost_t> v2{10, INF, 20, 6, 3};
+    std::vector<cost_t> v3{8, 20, INF, 4, 2};
+    std::vector<cost_t> v4{19, 6, 4, INF, 7};
+    std::vector<cost_t> v5{12, 3, 2, 7, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
 
@@ -24,11 +25,11 @@ TEST(StageStateTest, reduce_cost_matrix)
     cost_matrix_t new_matrix = stage.get_matrix().get_matrix();
 
     // Check if reduced matrix is correct
-    std::vector<int> v1_new{INF, 1, 0, 9, 4};
-    std::vector<int> v2_new{1, INF, 17, 1, 0};
-    std::vector<int> v3_new{0, 17, INF, 0, 0};
-    std::vector<int> v4_new{9, 1, 0, INF, 3};
-    std::vector<int> v5_new{4, 0, 0, 3, INF};
+    std::vector<cost_t> v1_new{INF, 1, 0, 9, 4};
+    std::vector<cost_t> v2_new{1, INF, 17, 1, 0};
+    std::vector<cost_t> v3_new{0, 17, INF, 0, 0};
+    std::vector<cost_t> v4_new{9, 1, 0, INF, 3};
+    std::vector<cost_t> v5_new{4, 0, 0, 3, INF};
 
     ASSERT_EQ(new_matrix[0], v1_new);
     ASSERT_EQ(new_matrix[1], v2_new);
@@ -61,11 +62,11 @@ TEST(StageStateTest, choose_new_vertex)
 TEST(StageStateTest, update_cost_matrix)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, INF, INF, INF, INF};
-    std::vector<int> v2{0, INF, INF, 1, 0};
-    std::vector<int> v3{INF, 17, INF, 0, 0};
-    std::vector<int> v4{7, 0, INF, INF, 2};
-    std::vector<int> v5{3, 0, INF, 3, INF};
+    std::vector<cost_t> v1{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v2{0, INF, INF, 1, 0};
+    std::vector<cost_t> v3{INF, 17, INF, 0, 0};
+    std::vector<cost_t> v4{7, 0, INF, INF, 2};
+    std::vector<cost_t> v5{3, 0, INF, 3, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
 
@@ -79,11 +80,11 @@ TEST(StageStateTest, update_cost_matrix)
     cost_matrix_t new_matrix = stage.get_matrix().get_matrix();
 
     // Assert new matrix
-    std::vector<int> v1_new{INF, INF, INF, INF, INF};
-    std::vector<int> v2_new{INF, INF, INF, INF, INF};
-    std::vector<int> v3_new{INF, INF, INF, 0, 0};
-    std::vector<int> v4_new{INF, 0, INF, INF, 2};
-    std::vector<int> v5_new{INF, 0, INF, 3, INF};
+    std::vector<cost_t> v1_new{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v2_new{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v3_new{INF, INF, INF, 0, 0};
+    std::vector<cost_t> v4_new{INF, 0, INF, INF, 2};
+    std::vector<cost_t> v5_new{INF, 0, INF, 3, INF};
 
     ASSERT_EQ(new_matrix[0], v1_new);
     ASSERT_EQ(new_matrix[1], v2_new);
@@ -95,11 +96,11 @@ TEST(StageStateTest, update_cost_matrix)
 TEST(StageStateTest, get_path)
 {
     // Deklaracja macierzy
-    std::vector<int> v1{INF, INF, INF, INF, INF};
-    std::vector<int> v2{INF, INF, INF, INF, INF};
-    std::vector<int> v3{INF, INF, INF, INF, INF};
-    std::vector<int> v4{INF, INF, INF, INF, 2};
-    std::vector<int> v5{INF, 0, INF, INF, INF};
+    std::vector<cost_t> v1{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v2{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v3{INF, INF, INF, INF, INF};
+    std::vector<cost_t> v4{INF, INF, INF, INF, 2};
+    std::vector<cost_t> v5{INF, 0, INF, INF, INF};
     cost_matrix_t cost_matrix{v1, v2, v3, v4, v5};
     CostMatrix matrix(cost_matrix);
 
@@ -108,4 +109,83 @@ TEST(StageStateTest, get_path)
 
     // Update Cost Matrix
     // path_t p = stage.get_path();
-}
\ No newline at end of file
+}
+TEST(StageStateTest, update_cost_matrix_shrinking)
+{
+    cost_matrix_t cm = {{INF, 1, 0, 9, 4},
+                        {1, INF, 17, 1, 0},
+                        {0, 17, INF, 0, 0},
+                        {9, 1, 0, INF, 3},
+                        {4, 0, 0, 3, INF}};
+    CostMatrix matrix(cm);
+
+    // Declare Stage State which drops chosen rows and columns
+    StageState stage(matrix, {}, 0, StageState::Layout::Shrinking);
+    stage.append_to_path(vertex_t(0, 2));
+    stage.update_cost_matrix(vertex_t(0, 2));
+
+    // Row 0 and column 2 are gone, going back from 2 to 0 is forbidden
+    std::vector<std::size_t> rows{1, 2, 3, 4};
+    std::vector<std::size_t> cols{0, 1, 3, 4};
+    ASSERT_EQ(stage.get_rows(), rows);
+    ASSERT_EQ(stage.get_cols(), cols);
+
+    cost_matrix_t expected = {{1, INF, 1, 0},
+                              {INF, 17, 0, 0},
+                              {9, 1, INF, 3},
+                              {4, 0, 3, INF}};
+    ASSERT_EQ(stage.get_matrix().get_matrix(), expected);
+
+    // Vertices are reported in the original indexing
+    stage.reduce_cost_matrix();
+    NewVertex vert = stage.choose_new_vertex();
+    auto row = std::find(rows.cbegin(), rows.cend(), vert.coordinates.row) - rows.cbegin();
+    auto col = std::find(cols.cbegin(), cols.cend(), vert.coordinates.col) - cols.cbegin();
+    ASSERT_LT(row, 4);
+    ASSERT_LT(col, 4);
+    ASSERT_EQ(stage.get_matrix()[static_cast<std::size_t>(row)][static_cast<std::size_t>(col)], 0);
+}
+
+TEST(StageStateTest, get_path_shrinking)
+{
+    cost_matrix_t cm = {{INF, 10, 8, 19, 12},
+                        {10, INF, 20, 6, 3},
+                        {8, 20, INF, 4, 2},
+                        {19, 6, 4, INF, 7},
+                        {12, 3, 2, 7, INF}};
+
+    // Fix 0 -> 2 -> 3 -> 1 and let the last 2x2 matrix close the tour
+    StageState stage(CostMatrix(cm), {}, 0, StageState::Layout::Shrinking);
+    for (const vertex_t &v : {vertex_t(0, 2), vertex_t(2, 3), vertex_t(3, 1)})
+    {
+        stage.append_to_path(v);
+        stage.update_cost_matrix(v);
+    }
+    ASSERT_EQ(stage.get_matrix().size(), 2u);
+
+    path_t expected{1, 3, 4, 2, 5};
+    ASSERT_EQ(stage.get_path(), expected);
+}
+
+TEST(StageStateTest, update_cost_matrix_joins_fragments)
+{
+    cost_matrix_t cm = {{INF, 1, 2, 3, 4, 5},
+                        {1, INF, 2, 3, 4, 5},
+                        {1, 2, INF, 3, 4, 5},
+                        {1, 2, 3, INF, 4, 5},
+                        {1, 2, 3, 4, INF, 5},
+                        {1, 2, 3, 4, 5, INF}};
+
+    // Two fragments, 0 -> 1 and 2 -> 3, joined into 0 -> 1 -> 2 -> 3
+    StageState stage(CostMatrix(cm), {vertex_t(0, 1), vertex_t(2, 3)});
+    stage.append_to_path(vertex_t(1, 2));
+    stage.update_cost_matrix(vertex_t(1, 2));
+    ASSERT_TRUE(is_inf(stage.get_matrix()[3][0]));
+    ASSERT_EQ(stage.get_matrix()[3][4], 4);
+
+    // Adding 4 -> 0 makes the fragment 4 -> ... -> 3, closed by 3 -> 4
+    stage.append_to_path(vertex_t(4, 0));
+    stage.update_cost_matrix(vertex_t(4, 0));
+    ASSERT_TRUE(is_inf(stage.get_matrix()[3][4]));
+    ASSERT_EQ(stage.get_matrix()[3][5], 5);
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+#include "TSP.hpp"
+#include "tsp_tsplib.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Write the text into a temporary file.
+ * @return The path of the file.
+ */
+static std::string write_file(const std::string &name, const std::string &text)
+{
+    const std::string path = ::testing::TempDir() + name;
+    std::ofstream(path) << text;
+    return path;
+}
+
+TEST(TsplibTest, full_matrix)
+{
+    const std::string path = write_file("full.atsp",
+                                        "NAME: full\n"
+                                        "TYPE: ATSP\n"
+                                        "COMMENT: a test\n"
+                                        "DIMENSION: 3\n"
+                                        "EDGE_WEIGHT_TYPE: EXPLICIT\n"
+                                        "EDGE_WEIGHT_FORMAT: FULL_MATRIX\n"
+                                        "EDGE_WEIGHT_SECTION\n"
+                                        " 0 1 2\n"
+                                        " 3 0 4\n"
+                                        " 5 6 0\n"
+                                        "EOF\n");
+    const tsplib_instance_t instance = load_tsplib(path);
+
+    ASSERT_EQ(instance.name, "full");
+    cost_matrix_t expected = {{INF, 1, 2}, {3, INF, 4}, {5, 6, INF}};
+    ASSERT_EQ(get_cost_matrix(instance), expected);
+}
+
+TEST(TsplibTest, upper_row)
+{
+    const std::string path = write_file("upper.tsp",
+                                        "NAME : upper\n"
+                                        "TYPE : TSP\n"
+                                        "DIMENSION : 4\n"
+                                        "EDGE_WEIGHT_TYPE : EXPLICIT\n"
+                                        "EDGE_WEIGHT_FORMAT : UPPER_ROW\n"
+                                        "EDGE_WEIGHT_SECTION\n"
+                                        "1 2 3\n"
+                                        "4 5\n"
+                                        "6\n");
+    const tsplib_instance_t instance = load_tsplib(path);
+
+    cost_matrix_t expected = {{INF, 1, 2, 3}, {1, INF, 4, 5}, {2, 4, INF, 6}, {3, 5, 6, INF}};
+    ASSERT_EQ(get_cost_matrix(instance), expected);
+}
+
+TEST(TsplibTest, coordinates)
+{
+    const std::string path = write_file("euc.tsp",
+                                        "NAME: euc\n"
+                                        "TYPE: TSP\n"
+                                        "DIMENSION: 3\n"
+                                        "EDGE_WEIGHT_TYPE: EUC_2D\n"
+                                        "NODE_COORD_SECTION\n"
+                                        "1 0 0\n"
+                                        "3 3.0e0 4.4\n"
+                                        "2 -1.5 +0\n"
+                                        "EOF\n");
+    const tsplib_instance_t instance = load_tsplib(path);
+
+    ASSERT_EQ(instance.size(), 3u);
+    ASSERT_EQ(get_tsplib_distance(instance, 0, 2), 5);
+    ASSERT_EQ(get_tsplib_distance(instance, 0, 1), 2);
+    ASSERT_EQ(get_tsplib_distance(instance, 1, 1), INF);
+
+    tsplib_instance_t ceil = instance;
+    ceil.weight_type = tsplib_weight_type_t::Ceil2D;
+    ASSERT_EQ(get_tsplib_distance(ceil, 0, 2), 6);
+}
+
+TEST(TsplibTest, geo)
+{
+    // Two cities of ulysses16 (TSPLIB), 509 apart.
+    tsplib_instance_t instance;
+    instance.weight_type = tsplib_weight_type_t::Geo;
+    instance.points = {{38.24, 20.42}, {39.57, 26.15}};
+    ASSERT_EQ(get_tsplib_distance(instance, 0, 1), 509);
+    ASSERT_EQ(get_tsplib_distance(instance, 1, 0), 509);
+}
+
+TEST(TsplibTest, errors)
+{
+    ASSERT_THROW(load_tsplib(::testing::TempDir() + "missing.tsp"), std::runtime_error);
+    ASSERT_THROW(load_tsplib(write_file("bad.tsp",
+                                        "DIMENSION: 2\n"
+                                        "EDGE_WEIGHT_TYPE: EXPLICIT\n"
+                                        "EDGE_WEIGHT_FORMAT: FULL_MATRIX\n"
+                                        "EDGE_WEIGHT_SECTION\n"
+                                        "0 x\n")), std::runtime_error);
+    ASSERT_THROW(load_tsplib(write_file("type.tsp", "EDGE_WEIGHT_TYPE: MAN_3D\n")), std::runtime_error);
+}